@@ -28,6 +28,19 @@
 
 #include <wolfssl/wolfcrypt/async.h>
 
+#if defined(WC_ASYNC_EVENTFD) && defined(WOLFSSL_ASYNC_CRYPT_SW)
+    #include <sys/eventfd.h>
+    #include <unistd.h>
+    #include <errno.h>
+    #include <pthread.h>
+#endif
+#if defined(WC_ASYNC_THRESH_CALIBRATE) || defined(WC_ASYNC_SW_POLL_BUDGET)
+    #include <time.h>
+#endif
+#if defined(WC_ASYNC_COMPLETION_RING) && !defined(SINGLE_THREADED)
+    #include <pthread.h>
+#endif
+
 
 static WC_ASYNC_DEV* wolfAsync_GetDev(WOLF_EVENT* event)
 {
@@ -67,6 +80,64 @@ static WC_ASYNC_DEV* wolfAsync_GetDev(WOLF_EVENT* event)
 /* Allow way to have async SW code included, and disabled at run-time */
 static int wolfAsyncSwDisabled = 0; /* default off */
 
+#ifdef WC_ASYNC_EVENTFD
+/* SW simulator notification: readable while SW work is queued */
+static int wolfAsyncSwEventFd = -1;
+static int wolfAsyncSwEventFdSignaled = 0;
+static int wolfAsyncSwEventFdCount = 0;
+/* protects fd and count, so no write goes to a closed or reused fd */
+static pthread_mutex_t wolfAsyncSwEventFdLock = PTHREAD_MUTEX_INITIALIZER;
+
+static int wolfAsync_SwEventFdOpen(void)
+{
+    int ret = 0;
+
+    pthread_mutex_lock(&wolfAsyncSwEventFdLock);
+    if (wolfAsyncSwEventFdCount == 0) {
+        wolfAsyncSwEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wolfAsyncSwEventFd < 0) {
+            fprintf(stderr, "eventfd failed with errno %d\n", errno);
+            ret = ASYNC_INIT_E;
+        }
+        else {
+            __atomic_store_n(&wolfAsyncSwEventFdSignaled, 0, __ATOMIC_RELEASE);
+        }
+    }
+    if (ret == 0) {
+        wolfAsyncSwEventFdCount++;
+    }
+    pthread_mutex_unlock(&wolfAsyncSwEventFdLock);
+
+    return ret;
+}
+
+static void wolfAsync_SwEventFdClose(void)
+{
+    pthread_mutex_lock(&wolfAsyncSwEventFdLock);
+    if (wolfAsyncSwEventFdCount > 0 && --wolfAsyncSwEventFdCount == 0) {
+        close(wolfAsyncSwEventFd);
+        wolfAsyncSwEventFd = -1;
+    }
+    pthread_mutex_unlock(&wolfAsyncSwEventFdLock);
+}
+
+/* wake application, only one write until application acknowledges */
+static void wolfAsync_SwEventFdSignal(void)
+{
+    word64 val = 1;
+
+    if (__atomic_exchange_n(&wolfAsyncSwEventFdSignaled, 1,
+                                                    __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_lock(&wolfAsyncSwEventFdLock);
+        if (wolfAsyncSwEventFd >= 0 &&
+                write(wolfAsyncSwEventFd, &val, sizeof(val)) != sizeof(val)) {
+            /* counter full means already readable */
+        }
+        pthread_mutex_unlock(&wolfAsyncSwEventFdLock);
+    }
+}
+#endif /* WC_ASYNC_EVENTFD */
+
 
 static int wolfAsync_DoSw(WC_ASYNC_DEV* asyncDev)
 {
@@ -245,6 +316,72 @@ static int wolfAsync_DoSw(WC_ASYNC_DEV* asyncDev)
         }
         #endif /* HAVE_AES_DECRYPT */
     #endif /* HAVE_AESGCM */
+
+    #ifdef HAVE_AESCCM
+        case ASYNC_SW_AES_CCM_ENCRYPT:
+        {
+            ret = wc_AesCcmEncrypt(
+                (Aes*)sw->aes.aes,
+                sw->aes.out,
+                sw->aes.in,
+                sw->aes.sz,
+                sw->aes.iv,
+                sw->aes.ivSz,
+                sw->aes.authTag,
+                sw->aes.authTagSz,
+                sw->aes.authIn,
+                sw->aes.authInSz
+            );
+            break;
+        }
+        #ifdef HAVE_AES_DECRYPT
+        case ASYNC_SW_AES_CCM_DECRYPT:
+        {
+            ret = wc_AesCcmDecrypt(
+                (Aes*)sw->aes.aes,
+                sw->aes.out,
+                sw->aes.in,
+                sw->aes.sz,
+                sw->aes.iv,
+                sw->aes.ivSz,
+                sw->aes.authTag,
+                sw->aes.authTagSz,
+                sw->aes.authIn,
+                sw->aes.authInSz
+            );
+            break;
+        }
+        #endif /* HAVE_AES_DECRYPT */
+    #endif /* HAVE_AESCCM */
+
+    #ifdef WOLFSSL_AES_XTS
+        case ASYNC_SW_AES_XTS_ENCRYPT:
+        {
+            ret = wc_AesXtsEncrypt(
+                (XtsAes*)sw->aes.aes,
+                sw->aes.out,
+                sw->aes.in,
+                sw->aes.sz,
+                sw->aes.iv,
+                sw->aes.ivSz
+            );
+            break;
+        }
+        #ifdef HAVE_AES_DECRYPT
+        case ASYNC_SW_AES_XTS_DECRYPT:
+        {
+            ret = wc_AesXtsDecrypt(
+                (XtsAes*)sw->aes.aes,
+                sw->aes.out,
+                sw->aes.in,
+                sw->aes.sz,
+                sw->aes.iv,
+                sw->aes.ivSz
+            );
+            break;
+        }
+        #endif /* HAVE_AES_DECRYPT */
+    #endif /* WOLFSSL_AES_XTS */
 #endif /* !NO_AES */
 #ifndef NO_DES3
         case ASYNC_SW_DES3_CBC_ENCRYPT:
@@ -268,6 +405,36 @@ static int wolfAsync_DoSw(WC_ASYNC_DEV* asyncDev)
             break;
         }
 #endif /* !NO_DES3 */
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+        case ASYNC_SW_CHACHA20_POLY1305_ENCRYPT:
+        {
+            ret = wc_ChaCha20Poly1305_Encrypt(
+                sw->chachaPoly.key,
+                sw->chachaPoly.iv,
+                sw->chachaPoly.authIn,
+                sw->chachaPoly.authInSz,
+                sw->chachaPoly.in,
+                sw->chachaPoly.sz,
+                sw->chachaPoly.out,
+                sw->chachaPoly.authTag
+            );
+            break;
+        }
+        case ASYNC_SW_CHACHA20_POLY1305_DECRYPT:
+        {
+            ret = wc_ChaCha20Poly1305_Decrypt(
+                sw->chachaPoly.key,
+                sw->chachaPoly.iv,
+                sw->chachaPoly.authIn,
+                sw->chachaPoly.authInSz,
+                sw->chachaPoly.in,
+                sw->chachaPoly.sz,
+                sw->chachaPoly.authTag,
+                sw->chachaPoly.out
+            );
+            break;
+        }
+#endif /* HAVE_CHACHA && HAVE_POLY1305 */
         default:
             WOLFSSL_MSG("Invalid async crypt SW type!");
             ret = BAD_FUNC_ARG;
@@ -297,177 +464,1981 @@ int wc_AsyncSwInit(WC_ASYNC_DEV* dev, int type)
     return 0;
 }
 
-#endif /* WOLFSSL_ASYNC_CRYPT_SW */
+#ifdef WC_ASYNC_SW_THREADS
+/* SW worker pool: the poller queues the operation and a worker runs it. Each
+ * worker has its own queue, fed by threads running on its core, and idle
+ * workers steal from the others */
+enum {
+    ASYNC_SW_POOL_IDLE = 0,
+    ASYNC_SW_POOL_QUEUED,
+    ASYNC_SW_POOL_RUNNING,
+    ASYNC_SW_POOL_COMPLETE, /* result set, worker signaling completion */
+    ASYNC_SW_POOL_DONE,
+};
+
+struct WC_ASYNC_SW_POOL;
+
+typedef struct WC_ASYNC_SW_WORKER {
+    pthread_mutex_t     lock; /* protects queue */
+    pthread_cond_t      cond; /* wait with pool lock */
+    WC_ASYNC_DEV*       head;
+    WC_ASYNC_DEV*       tail;
+    struct WC_ASYNC_SW_POOL* pool;
+    pthread_t           thread;
+    int                 id;
+    int                 sleeping;
+} WC_ASYNC_SW_WORKER;
+
+typedef struct WC_ASYNC_SW_POOL {
+    pthread_mutex_t     lock; /* protects sleep and stop */
+    pthread_cond_t      cond; /* stop and cancel wait with pool lock */
+    WC_ASYNC_SW_WORKER* workers;
+    int                 count; /* running workers */
+    int                 refs; /* start count */
+    int                 stop; /* no new operations queued */
+    int                 quit; /* workers exit once queues are drained */
+    int                 users; /* threads using workers, stop waits on them */
+    int                 cancels; /* threads waiting for a running operation */
+    int                 pending; /* queued operations */
+    int                 sleeping; /* idle workers */
+    word32              next; /* round robin when core is unknown */
+} WC_ASYNC_SW_POOL;
+
+static WC_ASYNC_SW_POOL wolfAsyncSwPool = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL,
+    0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/* done using workers */
+static void wolfAsync_SwPoolLeave(WC_ASYNC_SW_POOL* pool)
+{
+    if (__atomic_sub_fetch(&pool->users, 1, __ATOMIC_SEQ_CST) == 0 &&
+            __atomic_load_n(&pool->stop, __ATOMIC_SEQ_CST)) {
+        /* last user, wake stop */
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_broadcast(&pool->cond);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
 
-int wolfAsync_DevOpenThread(int *pDevId, void* threadId)
+/* keep workers from being freed, fails once pool is stopping */
+static int wolfAsync_SwPoolEnter(WC_ASYNC_SW_POOL* pool)
 {
-    int ret = 0;
-    int devId = INVALID_DEVID;
+    __atomic_add_fetch(&pool->users, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pool->stop, __ATOMIC_SEQ_CST)) {
+        wolfAsync_SwPoolLeave(pool);
+        return 0;
+    }
+    return 1;
+}
 
-#ifdef HAVE_CAVIUM
-    ret = NitroxOpenDeviceDefault();
-    if (ret >= 0)
-        devId = ret;
-    else
-        ret = ASYNC_INIT_E;
-#elif defined(HAVE_INTEL_QA)
-    ret = IntelQaInit(threadId);
-    if (ret >= 0)
-        devId = ret;
-    else
-        ret = ASYNC_INIT_E;
-#elif defined(WOLFSSL_ASYNC_CRYPT_SW)
-    if (!wolfAsyncSwDisabled) {
-        /* For SW use any value 0 or greater */
-        devId = 0;
+static void wolfAsync_SwQueuePush(WC_ASYNC_SW_WORKER* w,
+    WC_ASYNC_DEV* asyncDev)
+{
+    asyncDev->sw.poolNext = NULL;
+    pthread_mutex_lock(&w->lock);
+    if (w->tail != NULL) {
+        w->tail->sw.poolNext = asyncDev;
+    }
+    else {
+        __atomic_store_n(&w->head, asyncDev, __ATOMIC_RELAXED);
+    }
+    w->tail = asyncDev;
+    pthread_mutex_unlock(&w->lock);
+}
+
+/* oldest first, for both owner and thieves, so no operation is starved */
+static WC_ASYNC_DEV* wolfAsync_SwQueuePop(WC_ASYNC_SW_WORKER* w)
+{
+    WC_ASYNC_DEV* asyncDev;
+
+    pthread_mutex_lock(&w->lock);
+    asyncDev = w->head;
+    if (asyncDev != NULL) {
+        __atomic_store_n(&w->head, asyncDev->sw.poolNext, __ATOMIC_RELAXED);
+        if (w->head == NULL) {
+            w->tail = NULL;
+        }
+        /* set with queue locked so cancel knows where it is */
+        __atomic_store_n(&asyncDev->sw.poolState, ASYNC_SW_POOL_RUNNING,
+                                                            __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    return asyncDev;
+}
+
+/* own queue first, then steal from the other workers */
+static WC_ASYNC_DEV* wolfAsync_SwPoolTake(WC_ASYNC_SW_WORKER* w)
+{
+    WC_ASYNC_SW_POOL* pool = w->pool;
+    WC_ASYNC_DEV* asyncDev;
+    int i, victim, count;
+
+    asyncDev = wolfAsync_SwQueuePop(w);
+    count = __atomic_load_n(&pool->count, __ATOMIC_ACQUIRE);
+    for (i = 1; asyncDev == NULL && i < count; i++) {
+        victim = (w->id + i) % count;
+        /* skip empty queues without taking their lock */
+        if (__atomic_load_n(&pool->workers[victim].head,
+                                                __ATOMIC_RELAXED) != NULL) {
+            asyncDev = wolfAsync_SwQueuePop(&pool->workers[victim]);
+        }
+    }
+    if (asyncDev != NULL) {
+        __atomic_sub_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST);
     }
+
+    return asyncDev;
+}
+
+static void* wolfAsync_SwPoolWorker(void* arg)
+{
+    WC_ASYNC_SW_WORKER* w = (WC_ASYNC_SW_WORKER*)arg;
+    WC_ASYNC_SW_POOL* pool = w->pool;
+    WC_ASYNC_DEV* asyncDev;
+    int ret;
+
+    for (;;) {
+        asyncDev = wolfAsync_SwPoolTake(w);
+        if (asyncDev == NULL) {
+            pthread_mutex_lock(&pool->lock);
+            __atomic_add_fetch(&pool->sleeping, 1, __ATOMIC_SEQ_CST);
+            w->sleeping = 1;
+            while (__atomic_load_n(&pool->pending, __ATOMIC_SEQ_CST) == 0 &&
+                                                                !pool->quit) {
+                pthread_cond_wait(&w->cond, &pool->lock);
+            }
+            w->sleeping = 0;
+            __atomic_sub_fetch(&pool->sleeping, 1, __ATOMIC_SEQ_CST);
+            ret = pool->quit &&
+                    __atomic_load_n(&pool->pending, __ATOMIC_SEQ_CST) == 0;
+            pthread_mutex_unlock(&pool->lock);
+
+            /* only exit once queues are drained */
+            if (ret) {
+                break;
+            }
+            continue;
+        }
+        asyncDev->sw.poolNext = NULL;
+
+        /* non-blocking math has nothing to yield to here, so run it out */
+        do {
+            ret = wolfAsync_DoSw(asyncDev);
+        } while (ret == WC_PENDING_E);
+
+        asyncDev->sw.poolRet = ret;
+    #ifdef WC_ASYNC_COMPLETION_RING
+        /* push to ring before done, device may be freed once done */
+        __atomic_store_n(&asyncDev->sw.poolState, ASYNC_SW_POOL_COMPLETE,
+                                                            __ATOMIC_SEQ_CST);
+        wolfAsync_EventComplete(asyncDev);
+    #endif
+        __atomic_store_n(&asyncDev->sw.poolState, ASYNC_SW_POOL_DONE,
+                                                            __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&pool->cancels, __ATOMIC_SEQ_CST) > 0) {
+            /* device may be freed once cancel sees done */
+            pthread_mutex_lock(&pool->lock);
+            pthread_cond_broadcast(&pool->cond);
+            pthread_mutex_unlock(&pool->lock);
+        }
+    #ifdef WC_ASYNC_EVENTFD
+        wolfAsync_SwEventFdSignal();
+    #endif
+    }
+
+    return NULL;
+}
+
+/* worker bound to the calling thread's core, so the key stays in its cache */
+static int wolfAsync_SwPoolLocal(WC_ASYNC_SW_POOL* pool, int count)
+{
+    int cpu = -1;
+
+#ifdef __linux__
+    cpu = sched_getcpu();
 #endif
+    if (cpu < 0) {
+        cpu = (int)(__atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED) &
+                                                                0x7FFFFFFF);
+    }
 
-    (void)threadId;
+    return cpu % count;
+}
 
-    /* return devId if requested */
-    if (*pDevId)
-        *pDevId = devId;
+/* queue pending operation to worker pool, fails if there is nothing to queue
+ * or pool is not running */
+static int wolfAsync_SwPoolSubmit(WC_ASYNC_DEV* asyncDev)
+{
+    WC_ASYNC_SW_POOL* pool = &wolfAsyncSwPool;
+    WC_ASYNC_SW_WORKER* w;
+    int i, count;
+
+    if (asyncDev == NULL || asyncDev->sw.type == ASYNC_SW_NONE ||
+            asyncDev->sw.poolState != ASYNC_SW_POOL_IDLE) {
+        return BAD_FUNC_ARG;
+    }
+
+    if (!wolfAsync_SwPoolEnter(pool)) {
+        return ASYNC_OP_E;
+    }
+    count = __atomic_load_n(&pool->count, __ATOMIC_ACQUIRE);
+    if (count == 0) {
+        wolfAsync_SwPoolLeave(pool);
+        return ASYNC_OP_E;
+    }
+
+    __atomic_store_n(&asyncDev->sw.poolState, ASYNC_SW_POOL_QUEUED,
+                                                            __ATOMIC_RELAXED);
+    w = &pool->workers[wolfAsync_SwPoolLocal(pool, count)];
+    wolfAsync_SwQueuePush(w, asyncDev);
+    __atomic_add_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST);
+
+    /* wake local worker, or any idle one to steal it */
+    if (__atomic_load_n(&pool->sleeping, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&pool->lock);
+        if (!w->sleeping) {
+            for (i = 0; i < count; i++) {
+                if (pool->workers[i].sleeping) {
+                    w = &pool->workers[i];
+                    break;
+                }
+            }
+        }
+        pthread_cond_signal(&w->cond);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    wolfAsync_SwPoolLeave(pool);
+
+    return 0;
+}
+
+/* returns the event result, WC_PENDING_E until a worker has finished */
+static int wolfAsync_SwPoolRun(WC_ASYNC_DEV* asyncDev)
+{
+    WC_ASYNC_SW* sw = &asyncDev->sw;
+
+    switch (__atomic_load_n(&sw->poolState, __ATOMIC_ACQUIRE)) {
+        case ASYNC_SW_POOL_QUEUED:
+        case ASYNC_SW_POOL_RUNNING:
+        case ASYNC_SW_POOL_COMPLETE:
+            return WC_PENDING_E;
+        case ASYNC_SW_POOL_DONE:
+            sw->poolState = ASYNC_SW_POOL_IDLE;
+            return sw->poolRet;
+        default:
+            break;
+    }
+
+    /* run on this thread if nothing to queue or pool not started */
+    if (wolfAsync_SwPoolSubmit(asyncDev) != 0) {
+        return wolfAsync_DoSw(asyncDev);
+    }
+
+    return WC_PENDING_E;
+}
+
+/* take operation back from the pool before its memory is freed: unlinks it if
+ * still queued, otherwise waits for the worker running it */
+static void wolfAsync_SwPoolCancel(WC_ASYNC_DEV* asyncDev)
+{
+    WC_ASYNC_SW_POOL* pool = &wolfAsyncSwPool;
+    WC_ASYNC_SW_WORKER* w;
+    WC_ASYNC_DEV* cur;
+    WC_ASYNC_DEV* prev;
+    int i, count, found = 0;
+
+    if (__atomic_load_n(&asyncDev->sw.poolState, __ATOMIC_ACQUIRE) ==
+                                                        ASYNC_SW_POOL_IDLE) {
+        return;
+    }
+
+    /* operations only leave a queue when a worker takes them. A stopping
+     * pool runs everything queued, so just wait for it */
+    count = 0;
+    if (wolfAsync_SwPoolEnter(pool)) {
+        count = __atomic_load_n(&pool->count, __ATOMIC_ACQUIRE);
+    }
+    for (i = 0; i < count && !found; i++) {
+        w = &pool->workers[i];
+        pthread_mutex_lock(&w->lock);
+        if (__atomic_load_n(&asyncDev->sw.poolState, __ATOMIC_ACQUIRE) ==
+                                                    ASYNC_SW_POOL_QUEUED) {
+            prev = NULL;
+            for (cur = w->head; cur != NULL; cur = cur->sw.poolNext) {
+                if (cur == asyncDev) {
+                    if (prev != NULL) {
+                        prev->sw.poolNext = cur->sw.poolNext;
+                    }
+                    else {
+                        __atomic_store_n(&w->head, cur->sw.poolNext,
+                                                            __ATOMIC_RELAXED);
+                    }
+                    if (w->tail == cur) {
+                        w->tail = prev;
+                    }
+                    __atomic_sub_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST);
+                    found = 1;
+                    break;
+                }
+                prev = cur;
+            }
+        }
+        pthread_mutex_unlock(&w->lock);
+    }
+    if (count > 0) {
+        wolfAsync_SwPoolLeave(pool);
+    }
+
+    if (!found) {
+        /* running, worker is done with it once result is stored */
+        pthread_mutex_lock(&pool->lock);
+        __atomic_add_fetch(&pool->cancels, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&asyncDev->sw.poolState, __ATOMIC_SEQ_CST) !=
+                                                        ASYNC_SW_POOL_DONE) {
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        }
+        __atomic_sub_fetch(&pool->cancels, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    asyncDev->sw.poolNext = NULL;
+    asyncDev->sw.poolState = ASYNC_SW_POOL_IDLE;
+    asyncDev->sw.type = ASYNC_SW_NONE;
+}
+
+/* stops workers once every start has been matched, queued work is finished */
+static void wolfAsync_SwPoolStop(void)
+{
+    WC_ASYNC_SW_POOL* pool = &wolfAsyncSwPool;
+    int i, count;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->refs == 0 || --pool->refs > 0) {
+        pthread_mutex_unlock(&pool->lock);
+        return;
+    }
+    /* no new operations, then wait for threads still queuing */
+    __atomic_store_n(&pool->stop, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&pool->users, __ATOMIC_SEQ_CST) > 0) {
+        pthread_cond_wait(&pool->cond, &pool->lock);
+    }
+    /* workers run all queued operations before they exit */
+    pool->quit = 1;
+    count = pool->count;
+    for (i = 0; i < count; i++) {
+        pthread_cond_signal(&pool->workers[i].cond);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < count; i++) {
+        wc_AsyncThreadJoin(&pool->workers[i].thread);
+        pthread_mutex_destroy(&pool->workers[i].lock);
+        pthread_cond_destroy(&pool->workers[i].cond);
+    }
+    __atomic_store_n(&pool->count, 0, __ATOMIC_RELEASE);
+    XFREE(pool->workers, NULL, DYNAMIC_TYPE_ASYNC);
+    pool->workers = NULL;
+}
+
+static int wolfAsync_SwPoolStart(void)
+{
+    WC_ASYNC_SW_POOL* pool = &wolfAsyncSwPool;
+    WC_ASYNC_SW_WORKER* w;
+    int ret = 0, i, count, cpus;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->refs++ > 0) {
+        pthread_mutex_unlock(&pool->lock);
+        return 0; /* already started */
+    }
+
+    cpus = wc_AsyncGetNumberOfCpus();
+    count = WC_ASYNC_SW_THREADS;
+    if (count <= 0) {
+        count = (cpus > 0) ? cpus : 1;
+    }
+
+    pool->quit = 0;
+    __atomic_store_n(&pool->stop, 0, __ATOMIC_RELEASE);
+    pool->workers = (WC_ASYNC_SW_WORKER*)XMALLOC(
+                sizeof(WC_ASYNC_SW_WORKER) * count, NULL, DYNAMIC_TYPE_ASYNC);
+    if (pool->workers == NULL) {
+        ret = MEMORY_E;
+    }
+    for (i = 0; ret == 0 && i < count; i++) {
+        w = &pool->workers[i];
+        XMEMSET(w, 0, sizeof(WC_ASYNC_SW_WORKER));
+        w->pool = pool;
+        w->id = i;
+        pthread_mutex_init(&w->lock, NULL);
+        pthread_cond_init(&w->cond, NULL);
+
+        ret = wc_AsyncThreadCreate(&w->thread, wolfAsync_SwPoolWorker, w);
+        if (ret != 0) {
+            pthread_mutex_destroy(&w->lock);
+            pthread_cond_destroy(&w->cond);
+            break;
+        }
+        /* worker i serves core i, affinity is best effort */
+        if (cpus > 0) {
+            (void)wc_AsyncThreadBind(&w->thread, (word32)(i % cpus));
+        }
+        __atomic_store_n(&pool->count, i + 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (ret != 0) {
+        wolfAsync_SwPoolStop(); /* join any started workers */
+    }
+
+    return ret;
+}
+#endif /* WC_ASYNC_SW_THREADS */
+
+#ifdef WC_ASYNC_SW_POLL_BUDGET
+/* microseconds of SW work done by each wolfAsync_EventQueuePoll */
+static word32 wolfAsyncSwBudget = WC_ASYNC_SW_POLL_BUDGET;
+/* scheduling pass, an operation stepped in this pass waits until every other
+ * pending operation has had a step, even across polls */
+static THREAD_LS_T word32 wolfAsyncSwRound = 1;
+
+word32 wolfAsync_GetPollBudget(void)
+{
+    return __atomic_load_n(&wolfAsyncSwBudget, __ATOMIC_RELAXED);
+}
+
+int wolfAsync_SetPollBudget(word32 usec)
+{
+    __atomic_store_n(&wolfAsyncSwBudget, usec, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+static word64 wolfAsync_SwNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (word64)ts.tv_sec * 1000000ULL + (word64)ts.tv_nsec / 1000;
+}
+
+/* step pending SW operations round-robin until the budget is used, at least
+ * one step is done so every poll makes progress */
+static void wolfAsync_SwRunBudget(WOLF_EVENT_QUEUE* queue, void* context_filter)
+{
+    WOLF_EVENT* event;
+    WC_ASYNC_DEV* asyncDev;
+    word64 start = wolfAsync_SwNow();
+    word32 budget = wolfAsync_GetPollBudget();
+    int pending;
+
+    do {
+        pending = 0;
+        for (event = queue->head; event != NULL; event = event->next) {
+            if (event->type < WOLF_EVENT_TYPE_ASYNC_FIRST ||
+                event->type > WOLF_EVENT_TYPE_ASYNC_LAST ||
+                (context_filter != NULL && event->context != context_filter) ||
+                event->state == WOLF_EVENT_STATE_DONE ||
+                event->ret != WC_PENDING_E)
+            {
+                continue;
+            }
+            asyncDev = event->dev.async;
+            if (asyncDev == NULL) {
+                continue; /* reported by caller */
+            }
+
+            pending = 1;
+            if (asyncDev->sw.budgetRound == wolfAsyncSwRound) {
+                continue; /* already had a step in this pass */
+            }
+            asyncDev->sw.budgetRound = wolfAsyncSwRound;
+
+            event->ret = wolfAsync_DoSw(asyncDev);
+            if (wolfAsync_SwNow() - start >= budget) {
+                return;
+            }
+        }
+
+        /* pass done, start the next one (0 is never used by a new device) */
+        if (++wolfAsyncSwRound == 0) {
+            wolfAsyncSwRound = 1;
+        }
+    } while (pending);
+}
+#endif /* WC_ASYNC_SW_POLL_BUDGET */
+
+#ifdef WC_ASYNC_SW_ECDH_BATCH
+#ifndef wc_ecc_key_get_priv
+    #define wc_ecc_key_get_priv(key) (&((key)->k))
+#endif
+
+/* returns 1 if key is on a curve done with the generic math that is batched */
+static int wolfAsync_SwEccBatchCurve(ecc_key* key)
+{
+    if (key == NULL || key->dp == NULL || key->idx == ECC_CUSTOM_IDX) {
+        return 0;
+    }
+#ifdef WC_ECC_NONBLOCK
+    if (key->nb_ctx != NULL) {
+        return 0; /* caller asked for small steps */
+    }
+#endif
+#ifdef WOLFSSL_HAVE_SP_ECC
+    /* curves with SP code are faster one at a time */
+    #ifndef WOLFSSL_SP_NO_256
+    if (key->dp->id == ECC_SECP256R1) {
+        return 0;
+    }
+    #endif
+    #ifdef WOLFSSL_SP_384
+    if (key->dp->id == ECC_SECP384R1) {
+        return 0;
+    }
+    #endif
+    #ifdef WOLFSSL_SP_521
+    if (key->dp->id == ECC_SECP521R1) {
+        return 0;
+    }
+    #endif
+#endif
+
+    return 1;
+}
+
+/* Montgomery trick: out[i] = 1 / in[i] mod m using a single inversion, in[i]
+ * must not be zero. Optional blind hides the product from the inversion */
+static int wolfAsync_SwBatchInvert(mp_int** in, mp_int* out, int count,
+    mp_int* m, mp_int* blind, mp_int* t)
+{
+    int ret, i;
+
+    /* out[i] = in[0] * ... * in[i] */
+    ret = mp_copy(in[0], &out[0]);
+    for (i = 1; ret == MP_OKAY && i < count; i++) {
+        ret = mp_mulmod(&out[i - 1], in[i], m, &out[i]);
+    }
+    if (ret == MP_OKAY && blind != NULL) {
+        ret = mp_mulmod(&out[count - 1], blind, m, &out[count - 1]);
+    }
+    if (ret == MP_OKAY) {
+        ret = mp_invmod(&out[count - 1], m, t);
+    }
+    if (ret == MP_OKAY && blind != NULL) {
+        ret = mp_mulmod(t, blind, m, t);
+    }
+
+    /* t = 1 / (in[0] * ... * in[i]), peel off one input at a time */
+    for (i = count - 1; ret == MP_OKAY && i > 0; i--) {
+        ret = mp_mulmod(t, &out[i - 1], m, &out[i]);
+        if (ret == MP_OKAY) {
+            ret = mp_mulmod(t, in[i], m, t);
+        }
+    }
+    if (ret == MP_OKAY) {
+        ret = mp_copy(t, &out[0]);
+    }
+
+    return ret;
+}
+
+/* ECDH shared secrets on one curve, k * point is left projective and all Z
+ * are inverted together, the rest is as wc_ecc_shared_secret_gen_sync.
+ * Operations that cannot be batched, or hit an error, are left pending in
+ * rets */
+static void wolfAsync_SwEccSharedSecBatch(WC_ASYNC_DEV** devs, int* rets,
+    int count)
+{
+    struct AsyncCryptSwEccSharedSec* ss;
+    ecc_key* key = (ecc_key*)devs[0]->sw.eccSharedSec.private_key;
+    const ecc_set_type* dp = key->dp;
+    void* heap = key->heap;
+    ecc_point* R[WC_ASYNC_SW_ECDH_BATCH_MAX];
+    mp_int* z[WC_ASYNC_SW_ECDH_BATCH_MAX];
+    int idx[WC_ASYNC_SW_ECDH_BATCH_MAX];
+    mp_int* zinv = NULL;
+    mp_int prime, af, order, norm, blind, t;
+    WC_RNG* rng = NULL;
+    byte buf[MAX_ECC_BYTES];
+    word32 size = 0;
+    int ret, i, j, n = 0, inits = 0;
+
+    for (i = 0; i < count; i++) {
+        rets[i] = WC_PENDING_E;
+        R[i] = NULL;
+    }
+
+    ret = mp_init_multi(&prime, &af, &order, &norm, &blind, &t);
+    if (ret == MP_OKAY) {
+        zinv = (mp_int*)XMALLOC(sizeof(mp_int) * count, heap,
+                                                        DYNAMIC_TYPE_ECC);
+        if (zinv == NULL)
+            ret = MEMORY_E;
+    }
+    for (; ret == MP_OKAY && inits < count; inits++) {
+        ret = mp_init(&zinv[inits]);
+    }
+    if (ret == MP_OKAY)
+        ret = mp_read_radix(&prime, dp->prime, MP_RADIX_HEX);
+    if (ret == MP_OKAY)
+        ret = mp_read_radix(&af, dp->Af, MP_RADIX_HEX);
+    if (ret == MP_OKAY)
+        ret = mp_read_radix(&order, dp->order, MP_RADIX_HEX);
+    /* result of point multiply is in Montgomery form */
+    if (ret == MP_OKAY)
+        ret = mp_montgomery_calc_normalization(&norm, &prime);
+    if (ret == MP_OKAY)
+        size = (word32)mp_unsigned_bin_size(&prime);
+
+    /* R = k * point, unmapped. Invalid input and infinity are left for
+     * wc_ecc_shared_secret_gen_sync to report */
+    for (i = 0; ret == MP_OKAY && i < count; i++) {
+        ss = &devs[i]->sw.eccSharedSec;
+        key = (ecc_key*)ss->private_key;
+        if (ss->public_point == NULL || ss->out == NULL ||
+            ss->outLen == NULL || *ss->outLen < size || key->rng == NULL ||
+            (key->type != ECC_PRIVATEKEY && key->type != ECC_PRIVATEKEY_ONLY) ||
+        #ifdef HAVE_ECC_CDH
+            (key->flags & WC_ECC_FLAG_COFACTOR) ||
+        #endif
+            wc_ecc_point_is_on_curve((ecc_point*)ss->public_point,
+                                                        key->idx) != MP_OKAY)
+        {
+            continue;
+        }
+
+        R[i] = wc_ecc_new_point();
+        if (R[i] == NULL) {
+            ret = MEMORY_E;
+            break;
+        }
+        if (wc_ecc_mulmod_ex2(wc_ecc_key_get_priv(key),
+                (ecc_point*)ss->public_point, R[i], &af, &prime, &order,
+                key->rng, 0, heap) != MP_OKAY || mp_iszero(R[i]->z)) {
+            wc_ecc_del_point(R[i]);
+            R[i] = NULL;
+            continue;
+        }
+        rng = key->rng;
+        z[n] = R[i]->z;
+        idx[n++] = i;
+    }
+
+    /* 1 / Z for every point, blinded as Z depends on the private keys */
+    if (ret == MP_OKAY && n > 1) {
+        ret = wc_RNG_GenerateBlock(rng, buf, size);
+        if (ret == 0)
+            ret = mp_read_unsigned_bin(&blind, buf, size);
+        if (ret == MP_OKAY)
+            ret = mp_mod(&blind, &prime, &blind);
+        if (ret == MP_OKAY && mp_iszero(&blind))
+            ret = mp_set(&blind, 1);
+        ForceZero(buf, sizeof(buf));
+    }
+    if (ret == MP_OKAY && n > 1) {
+        ret = wolfAsync_SwBatchInvert(z, zinv, n, &prime, &blind, &t);
+    }
+
+    for (j = 0; ret == MP_OKAY && n > 1 && j < n; j++) {
+        i = idx[j];
+        ss = &devs[i]->sw.eccSharedSec;
+
+        /* x = X * R / Z^2 */
+        ret = mp_sqrmod(&zinv[j], &prime, &t);
+        if (ret == MP_OKAY)
+            ret = mp_mulmod(&t, R[i]->x, &prime, &t);
+        if (ret == MP_OKAY)
+            ret = mp_mulmod(&t, &norm, &prime, &t);
+        if (ret == MP_OKAY) {
+            XMEMSET(ss->out, 0, size);
+            ret = mp_to_unsigned_bin(&t,
+                            ss->out + (size - mp_unsigned_bin_size(&t)));
+        }
+        if (ret == MP_OKAY) {
+            *ss->outLen = size;
+            rets[i] = 0;
+        }
+    }
+
+    mp_clear(&prime);
+    mp_clear(&af);
+    mp_clear(&order);
+    mp_clear(&norm);
+    mp_forcezero(&blind);
+    mp_forcezero(&t);
+    for (i = 0; i < inits; i++) {
+        mp_forcezero(&zinv[i]);
+    }
+    XFREE(zinv, heap, DYNAMIC_TYPE_ECC);
+    for (i = 0; i < count; i++) {
+        if (R[i] != NULL) {
+            mp_forcezero(R[i]->x);
+            mp_forcezero(R[i]->y);
+            mp_forcezero(R[i]->z);
+            wc_ecc_del_point(R[i]);
+        }
+    }
+}
+
+/* key of a pending ECDH shared secret that can be batched, otherwise NULL */
+static ecc_key* wolfAsync_SwEcdhBatchKey(WC_ASYNC_DEV* asyncDev)
+{
+    ecc_key* key;
+
+    if (asyncDev == NULL || asyncDev->sw.type != ASYNC_SW_ECC_SHARED_SEC) {
+        return NULL;
+    }
+    key = (ecc_key*)asyncDev->sw.eccSharedSec.private_key;
+
+    return wolfAsync_SwEccBatchCurve(key) ? key : NULL;
+}
+
+/* run pending ECDH shared secrets on one curve together, anything the batch
+ * does not finish runs on its own */
+static void wolfAsync_SwEcdhBatch(WOLF_EVENT_QUEUE* queue, void* context_filter)
+{
+    WOLF_EVENT* events[WC_ASYNC_SW_ECDH_BATCH_MAX];
+    WC_ASYNC_DEV* devs[WC_ASYNC_SW_ECDH_BATCH_MAX];
+    int rets[WC_ASYNC_SW_ECDH_BATCH_MAX];
+    WOLF_EVENT* event;
+    ecc_key* key;
+    int count, curveId = 0, i, done;
+
+    do {
+        count = 0;
+        for (event = queue->head; event != NULL; event = event->next) {
+            if (event->type < WOLF_EVENT_TYPE_ASYNC_FIRST ||
+                event->type > WOLF_EVENT_TYPE_ASYNC_LAST ||
+                (context_filter != NULL && event->context != context_filter) ||
+                event->state == WOLF_EVENT_STATE_DONE ||
+                event->ret != WC_PENDING_E)
+            {
+                continue;
+            }
+            key = wolfAsync_SwEcdhBatchKey(event->dev.async);
+            if (key == NULL || (count > 0 && key->dp->id != curveId)) {
+                continue;
+            }
+            curveId = key->dp->id;
+            events[count] = event;
+            devs[count++] = event->dev.async;
+            if (count == WC_ASYNC_SW_ECDH_BATCH_MAX) {
+                break;
+            }
+        }
+        if (count < 2) {
+            break; /* nothing to share */
+        }
+
+        wolfAsync_SwEccSharedSecBatch(devs, rets, count);
+
+        /* next group only if this one is finished, else it is found again */
+        done = 1;
+        for (i = 0; i < count; i++) {
+            if (rets[i] == WC_PENDING_E) {
+                rets[i] = wolfAsync_DoSw(devs[i]);
+            }
+            else if (rets[i] == 0) {
+                devs[i]->sw.type = ASYNC_SW_NONE;
+            }
+            events[i]->ret = rets[i];
+            if (rets[i] == WC_PENDING_E) {
+                done = 0;
+            }
+        }
+    } while (done);
+}
+#endif /* WC_ASYNC_SW_ECDH_BATCH */
+
+#endif /* WOLFSSL_ASYNC_CRYPT_SW */
+
+int wolfAsync_DevOpenThread(int *pDevId, void* threadId)
+{
+    int ret = 0;
+    int devId = INVALID_DEVID;
+
+#ifdef HAVE_CAVIUM
+    ret = NitroxOpenDeviceDefault();
+    if (ret >= 0)
+        devId = ret;
+    else
+        ret = ASYNC_INIT_E;
+#elif defined(HAVE_INTEL_QA)
+    ret = IntelQaInit(threadId);
+    if (ret >= 0)
+        devId = ret;
+    else
+        ret = ASYNC_INIT_E;
+#elif defined(WOLFSSL_ASYNC_CRYPT_SW)
+    if (!wolfAsyncSwDisabled) {
+        /* For SW use any value 0 or greater */
+        devId = 0;
+    #ifdef WC_ASYNC_EVENTFD
+        ret = wolfAsync_SwEventFdOpen();
+        if (ret != 0)
+            devId = INVALID_DEVID;
+    #endif
+    }
+#endif
+
+    (void)threadId;
+
+    /* return devId if requested */
+    if (*pDevId)
+        *pDevId = devId;
+
+    return ret;
+}
+
+#ifdef WC_ASYNC_COMPLETION_RING
+static void wolfAsync_RingDevFree(WC_ASYNC_DEV* asyncDev);
+static void wolfAsync_RingCleanup(void);
+#endif
+
+int wolfAsync_HardwareStart(void)
+{
+    int ret = 0;
+
+    #ifdef HAVE_CAVIUM
+        /* nothing to do */
+    #elif defined(HAVE_INTEL_QA)
+        ret = IntelQaHardwareStart(QAT_PROCESS_NAME, QAT_LIMIT_DEV_ACCESS);
+    #elif defined(WC_ASYNC_SW_THREADS)
+        ret = wolfAsync_SwPoolStart();
+    #endif
+
+    #ifdef WC_ASYNC_THRESH_CALIBRATE
+        if (ret == 0 && wolfAsync_Calibrate(INVALID_DEVID) != 0) {
+            WOLFSSL_MSG("Async threshold calibration failed, using defaults");
+        }
+    #endif
+
+    return ret;
+}
+
+void wolfAsync_HardwareStop(void)
+{
+    #ifdef HAVE_CAVIUM
+        /* nothing to do */
+    #elif defined(HAVE_INTEL_QA)
+        IntelQaHardwareStop();
+    #elif defined(WC_ASYNC_SW_THREADS)
+        wolfAsync_SwPoolStop();
+    #endif
+    #ifdef WC_ASYNC_COMPLETION_RING
+        wolfAsync_RingCleanup();
+    #endif
+}
+
+int wolfAsync_DevOpen(int *devId)
+{
+    return wolfAsync_DevOpenThread(devId, NULL);
+}
+
+void wolfAsync_DevClose(int *devId)
+{
+    if (devId && *devId != INVALID_DEVID) {
+    #ifdef HAVE_CAVIUM
+        NitroxCloseDevice(*devId);
+    #elif defined(HAVE_INTEL_QA)
+        IntelQaDeInit(*devId);
+    #elif defined(WOLFSSL_ASYNC_CRYPT_SW) && defined(WC_ASYNC_EVENTFD)
+        wolfAsync_SwEventFdClose();
+    #endif
+        *devId = INVALID_DEVID;
+    }
+}
+
+int wolfAsync_DevCtxInit(WC_ASYNC_DEV* asyncDev, word32 marker, void* heap,
+    int devId)
+{
+    int ret = 0;
+
+    if (asyncDev == NULL) {
+        return BAD_FUNC_ARG;
+    }
+
+    /* always clear async device context */
+    XMEMSET(asyncDev, 0, sizeof(WC_ASYNC_DEV));
+
+    /* negative device Id's are invalid */
+    if (devId >= 0) {
+        asyncDev->marker = marker;
+        asyncDev->heap = heap;
+
+    #ifdef HAVE_CAVIUM
+        ret = NitroxAllocContext(asyncDev, devId, CONTEXT_SSL);
+    #elif defined(HAVE_INTEL_QA)
+        ret = IntelQaOpen(asyncDev, devId);
+    #endif
+    }
+
+    return ret;
+}
+
+void wolfAsync_DevCtxFree(WC_ASYNC_DEV* asyncDev, word32 marker)
+{
+    if (asyncDev && asyncDev->marker == marker) {
+    #ifdef WC_ASYNC_COMPLETION_RING
+        /* ring must not return an event for freed device */
+        wolfAsync_RingDevFree(asyncDev);
+    #endif
+    #ifdef HAVE_CAVIUM
+        NitroxFreeContext(asyncDev);
+    #elif defined(HAVE_INTEL_QA)
+        IntelQaClose(asyncDev);
+    #elif defined(WC_ASYNC_SW_THREADS)
+        /* worker must be done with the context before it is freed */
+        wolfAsync_SwPoolCancel(asyncDev);
+    #endif
+        asyncDev->marker = WOLFSSL_ASYNC_MARKER_INVALID;
+    }
+}
+
+int wolfAsync_DevCopy(WC_ASYNC_DEV* src, WC_ASYNC_DEV* dst)
+{
+    int ret = 0;
+
+    if (src == NULL || dst == NULL)
+        return BAD_FUNC_ARG;
+
+    /* make sure we aren't copying to self */
+    if (src == dst)
+        return ret;
+
+#ifdef HAVE_CAVIUM
+    /* nothing to do here */
+#elif defined(HAVE_INTEL_QA)
+    ret = IntelQaDevCopy(src, dst);
+#endif
+
+    return ret;
+}
+
+#ifdef WC_ASYNC_BATCH_SUBMIT
+/* batch open on this thread */
+static THREAD_LS_T WC_ASYNC_BATCH* wolfAsyncBatchCur = NULL;
+
+int wolfAsync_BatchBegin(WC_ASYNC_BATCH* batch)
+{
+    if (batch == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (wolfAsyncBatchCur != NULL) {
+        return BAD_STATE_E; /* batches do not nest */
+    }
+
+    XMEMSET(batch, 0, sizeof(WC_ASYNC_BATCH));
+    wolfAsyncBatchCur = batch;
+
+    return 0;
+}
+
+/* called by backend to hold operation, non-zero means submit it now */
+int wolfAsync_BatchAdd(WC_ASYNC_DEV* asyncDev)
+{
+    WC_ASYNC_BATCH* batch = wolfAsyncBatchCur;
+
+    if (asyncDev == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (batch == NULL || batch->count >= WC_ASYNC_BATCH_MAX) {
+        return BAD_STATE_E;
+    }
+
+    batch->devs[batch->count++] = asyncDev;
+
+    return 0;
+}
+
+/* returns number of operations submitted */
+int wolfAsync_BatchSubmit(WC_ASYNC_BATCH* batch)
+{
+    int ret = 0;
+
+    if (batch == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (wolfAsyncBatchCur == batch) {
+        wolfAsyncBatchCur = NULL;
+    }
+
+#if defined(HAVE_INTEL_QA)
+    ret = IntelQaBatchSubmit(batch->devs, batch->count);
+#endif
+    /* other backends do not hold operations */
+
+    batch->count = 0;
+
+    return ret;
+}
+#endif /* WC_ASYNC_BATCH_SUBMIT */
+
+#ifdef WC_ASYNC_THRESH_CALIBRATE
+/* sizes at or above threshold use the device */
+static word32 wolfAsyncThresh[WC_ASYNC_THRESH_ID_COUNT] = {
+    WC_ASYNC_THRESH_DEF_AES_CBC,
+    WC_ASYNC_THRESH_DEF_AES_GCM,
+    WC_ASYNC_THRESH_DEF_DES3_CBC,
+    WC_ASYNC_THRESH_DEF_AES_CCM,
+    WC_ASYNC_THRESH_DEF_AES_XTS,
+    WC_ASYNC_THRESH_DEF_CHACHA_POLY
+};
+/* thread is calibrating, send everything to the device */
+static THREAD_LS_T byte wolfAsyncThreshCal = 0;
+
+word32 wolfAsync_GetThreshold(int id)
+{
+    if (wolfAsyncThreshCal) {
+        return 0;
+    }
+    if (id < 0 || id >= WC_ASYNC_THRESH_ID_COUNT) {
+        return WC_ASYNC_THRESH_SW_ONLY;
+    }
+    return __atomic_load_n(&wolfAsyncThresh[id], __ATOMIC_RELAXED);
+}
+
+int wolfAsync_SetThreshold(int id, word32 sz)
+{
+    if (id < 0 || id >= WC_ASYNC_THRESH_ID_COUNT) {
+        return BAD_FUNC_ARG;
+    }
+    __atomic_store_n(&wolfAsyncThresh[id], sz, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+#if !defined(NO_AES) || !defined(NO_DES3)
+#define WC_ASYNC_CAL_TAG_SZ 16 /* room after output for GCM and CCM tag */
+#define WC_ASYNC_CAL_NONCE_SZ 12 /* CCM nonce */
+
+/* ChaCha20-Poly1305 has no context to carry a device and is not timed */
+typedef union WC_ASYNC_CAL_CTX {
+#ifndef NO_AES
+    Aes         aes;
+#endif
+#if !defined(NO_AES) && defined(WOLFSSL_AES_XTS)
+    XtsAes      xts;
+#endif
+#ifndef NO_DES3
+    Des3        des3;
+#endif
+} WC_ASYNC_CAL_CTX;
+
+/* key, IV and nonce for timing, contents do not matter */
+static const byte wolfAsyncCalKey[32] = {
+    0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+    0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10,
+    0x89, 0xab, 0xcd, 0xef, 0x01, 0x23, 0x45, 0x67,
+    0x76, 0x54, 0x32, 0x10, 0xfe, 0xdc, 0xba, 0x98
+};
+
+static word64 wolfAsync_CalNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (word64)ts.tv_sec * 1000000000ULL + (word64)ts.tv_nsec;
+}
+
+static int wolfAsync_CalInit(int id, WC_ASYNC_CAL_CTX* ctx, int devId)
+{
+    int ret = NOT_COMPILED_IN;
+
+    switch (id) {
+    #if !defined(NO_AES) && defined(HAVE_AES_CBC)
+        case WC_ASYNC_THRESH_ID_AES_CBC:
+            ret = wc_AesInit(&ctx->aes, NULL, devId);
+            if (ret == 0) {
+                ret = wc_AesSetKey(&ctx->aes, wolfAsyncCalKey,
+                    AES_128_KEY_SIZE, wolfAsyncCalKey, AES_ENCRYPTION);
+            }
+            break;
+    #endif
+    #if !defined(NO_AES) && defined(HAVE_AESGCM)
+        case WC_ASYNC_THRESH_ID_AES_GCM:
+            ret = wc_AesInit(&ctx->aes, NULL, devId);
+            if (ret == 0) {
+                ret = wc_AesGcmSetKey(&ctx->aes, wolfAsyncCalKey,
+                    AES_128_KEY_SIZE);
+            }
+            break;
+    #endif
+    #ifndef NO_DES3
+        case WC_ASYNC_THRESH_ID_DES3_CBC:
+            ret = wc_Des3Init(&ctx->des3, NULL, devId);
+            if (ret == 0) {
+                ret = wc_Des3_SetKey(&ctx->des3, wolfAsyncCalKey,
+                    wolfAsyncCalKey, DES_ENCRYPTION);
+            }
+            break;
+    #endif
+    #if !defined(NO_AES) && defined(HAVE_AESCCM)
+        case WC_ASYNC_THRESH_ID_AES_CCM:
+            ret = wc_AesInit(&ctx->aes, NULL, devId);
+            if (ret == 0) {
+                ret = wc_AesCcmSetKey(&ctx->aes, wolfAsyncCalKey,
+                    AES_128_KEY_SIZE);
+            }
+            break;
+    #endif
+    #if !defined(NO_AES) && defined(WOLFSSL_AES_XTS)
+        case WC_ASYNC_THRESH_ID_AES_XTS:
+            ret = wc_AesXtsSetKey(&ctx->xts, wolfAsyncCalKey,
+                2 * AES_128_KEY_SIZE, AES_ENCRYPTION, NULL, devId);
+            break;
+    #endif
+        default:
+            break;
+    }
+
+    return ret;
+}
+
+static void wolfAsync_CalFree(int id, WC_ASYNC_CAL_CTX* ctx)
+{
+    switch (id) {
+    #ifndef NO_AES
+        case WC_ASYNC_THRESH_ID_AES_CBC:
+        case WC_ASYNC_THRESH_ID_AES_GCM:
+        case WC_ASYNC_THRESH_ID_AES_CCM:
+            wc_AesFree(&ctx->aes);
+            break;
+    #endif
+    #if !defined(NO_AES) && defined(WOLFSSL_AES_XTS)
+        case WC_ASYNC_THRESH_ID_AES_XTS:
+            wc_AesXtsFree(&ctx->xts);
+            break;
+    #endif
+    #ifndef NO_DES3
+        case WC_ASYNC_THRESH_ID_DES3_CBC:
+            wc_Des3Free(&ctx->des3);
+            break;
+    #endif
+        default:
+            break;
+    }
+}
+
+/* start one encrypt, returns WC_PENDING_E when queued on the device */
+static int wolfAsync_CalOp(int id, WC_ASYNC_CAL_CTX* ctx, byte* out,
+    const byte* in, word32 sz, WC_ASYNC_DEV** asyncDev)
+{
+    int ret = NOT_COMPILED_IN;
+
+    switch (id) {
+    #if !defined(NO_AES) && defined(HAVE_AES_CBC)
+        case WC_ASYNC_THRESH_ID_AES_CBC:
+            *asyncDev = &ctx->aes.asyncDev;
+            ret = wc_AesCbcEncrypt(&ctx->aes, out, in, sz);
+            break;
+    #endif
+    #if !defined(NO_AES) && defined(HAVE_AESGCM)
+        case WC_ASYNC_THRESH_ID_AES_GCM:
+            *asyncDev = &ctx->aes.asyncDev;
+            ret = wc_AesGcmEncrypt(&ctx->aes, out, in, sz, wolfAsyncCalKey,
+                GCM_NONCE_MID_SZ, out + sz, WC_ASYNC_CAL_TAG_SZ, NULL, 0);
+            break;
+    #endif
+    #if !defined(NO_AES) && defined(HAVE_AESCCM)
+        case WC_ASYNC_THRESH_ID_AES_CCM:
+            *asyncDev = &ctx->aes.asyncDev;
+            ret = wc_AesCcmEncrypt(&ctx->aes, out, in, sz, wolfAsyncCalKey,
+                WC_ASYNC_CAL_NONCE_SZ, out + sz, WC_ASYNC_CAL_TAG_SZ, NULL, 0);
+            break;
+    #endif
+    #if !defined(NO_AES) && defined(WOLFSSL_AES_XTS)
+        case WC_ASYNC_THRESH_ID_AES_XTS:
+            *asyncDev = &ctx->xts.aes.asyncDev;
+            ret = wc_AesXtsEncrypt(&ctx->xts, out, in, sz, wolfAsyncCalKey,
+                AES_BLOCK_SIZE);
+            break;
+    #endif
+    #ifndef NO_DES3
+        case WC_ASYNC_THRESH_ID_DES3_CBC:
+            *asyncDev = &ctx->des3.asyncDev;
+            ret = wc_Des3_CbcEncrypt(&ctx->des3, out, in, sz);
+            break;
+    #endif
+        default:
+            break;
+    }
+
+    return ret;
+}
+
+/* average time per operation in nanoseconds, keeping up to depth contexts
+ * in flight so device throughput rather than latency is measured */
+static int wolfAsync_CalTime(int id, WC_ASYNC_CAL_CTX* ctx, int depth,
+    byte* out, const byte* in, word32 sz, word64* ns)
+{
+    int ret = 0, i, j, n, rets[WC_ASYNC_CAL_DEPTH];
+    WC_ASYNC_DEV* devs[WC_ASYNC_CAL_DEPTH];
+    word64 start = wolfAsync_CalNow();
+
+    for (i = 0; i < WC_ASYNC_CAL_ITERS && ret == 0; i += n) {
+        n = WC_ASYNC_CAL_ITERS - i;
+        if (n > depth)
+            n = depth;
+
+        for (j = 0; j < n; j++) {
+            rets[j] = wolfAsync_CalOp(id, &ctx[j],
+                out + j * (WC_ASYNC_CAL_MAX_SZ + WC_ASYNC_CAL_TAG_SZ),
+                in, sz, &devs[j]);
+        }
+        for (j = 0; j < n; j++) {
+            rets[j] = wc_AsyncWait(rets[j], devs[j], WC_ASYNC_FLAG_NONE);
+            if (rets[j] != 0 && ret == 0)
+                ret = rets[j];
+        }
+    }
+
+    *ns = (wolfAsync_CalNow() - start) / WC_ASYNC_CAL_ITERS;
+
+    return ret;
+}
+
+/* walk down from the largest size while the device stays faster, the last
+ * such size becomes the threshold. ctx holds one software context followed
+ * by WC_ASYNC_CAL_DEPTH device contexts */
+static int wolfAsync_CalibrateAlg(int id, int devId, WC_ASYNC_CAL_CTX* ctx,
+    byte* out, const byte* in)
+{
+    int ret, i;
+    word32 sz, thresh = WC_ASYNC_THRESH_SW_ONLY;
+    word64 swNs = 0, hwNs = 0;
+
+    XMEMSET(ctx, 0, sizeof(WC_ASYNC_CAL_CTX) * (WC_ASYNC_CAL_DEPTH + 1));
+    ret = wolfAsync_CalInit(id, &ctx[0], INVALID_DEVID);
+    for (i = 1; i <= WC_ASYNC_CAL_DEPTH && ret == 0; i++) {
+        ret = wolfAsync_CalInit(id, &ctx[i], devId);
+    }
+
+    for (sz = WC_ASYNC_CAL_MAX_SZ; sz >= WC_ASYNC_CAL_MIN_SZ && ret == 0;
+                                                                    sz /= 2) {
+        ret = wolfAsync_CalTime(id, &ctx[0], 1, out, in, sz, &swNs);
+        if (ret == 0) {
+            ret = wolfAsync_CalTime(id, &ctx[1], WC_ASYNC_CAL_DEPTH, out, in,
+                sz, &hwNs);
+        }
+        if (ret != 0 || hwNs >= swNs)
+            break;
+        thresh = sz;
+    }
+
+    if (ret != NOT_COMPILED_IN) {
+        for (i = 0; i <= WC_ASYNC_CAL_DEPTH; i++) {
+            wolfAsync_CalFree(id, &ctx[i]);
+        }
+    }
+    if (ret == 0) {
+        ret = wolfAsync_SetThreshold(id, thresh);
+    }
+
+    return ret;
+}
+#endif /* !NO_AES || !NO_DES3 */
+
+/* time each cipher in software and on the device per size bucket and set
+ * threshold to where the device becomes cheaper. Can be called again while
+ * under load, devId INVALID_DEVID opens a device for the calibration */
+int wolfAsync_Calibrate(int devId)
+{
+#if !defined(NO_AES) || !defined(NO_DES3)
+    int ret = 0, id, openDev = 0;
+    byte* in = NULL;
+    byte* out = NULL;
+    WC_ASYNC_CAL_CTX* ctx = NULL;
+
+    if (devId == INVALID_DEVID) {
+        ret = wolfAsync_DevOpen(&devId);
+        if (devId == INVALID_DEVID) {
+            return (ret < 0) ? ret : NO_VALID_DEVID;
+        }
+        ret = 0;
+        openDev = 1;
+    }
+
+    in = (byte*)XMALLOC(WC_ASYNC_CAL_MAX_SZ, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    out = (byte*)XMALLOC((WC_ASYNC_CAL_MAX_SZ + WC_ASYNC_CAL_TAG_SZ) *
+        WC_ASYNC_CAL_DEPTH, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    ctx = (WC_ASYNC_CAL_CTX*)XMALLOC(sizeof(WC_ASYNC_CAL_CTX) *
+        (WC_ASYNC_CAL_DEPTH + 1), NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    if (in == NULL || out == NULL || ctx == NULL) {
+        ret = MEMORY_E; goto exit;
+    }
+    XMEMSET(in, 0, WC_ASYNC_CAL_MAX_SZ);
+
+    wolfAsyncThreshCal = 1;
+    for (id = 0; id < WC_ASYNC_THRESH_ID_COUNT && ret == 0; id++) {
+        ret = wolfAsync_CalibrateAlg(id, devId, ctx, out, in);
+        if (ret == NOT_COMPILED_IN)
+            ret = 0;
+    }
+    wolfAsyncThreshCal = 0;
+
+exit:
+    XFREE(ctx, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(out, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(in, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    if (openDev) {
+        wolfAsync_DevClose(&devId);
+    }
+
+    return ret;
+#else
+    (void)devId;
+    return NOT_COMPILED_IN;
+#endif
+}
+#endif /* WC_ASYNC_THRESH_CALIBRATE */
+
+#ifdef WC_ASYNC_EVENTFD
+int wolfAsync_DevGetEventFd(int devId, int* fd)
+{
+    if (fd == NULL || devId < 0) {
+        return BAD_FUNC_ARG;
+    }
+    *fd = -1;
+
+#if defined(HAVE_INTEL_QA)
+    return IntelQaGetEventFd(devId, fd);
+#elif defined(WOLFSSL_ASYNC_CRYPT_SW)
+    pthread_mutex_lock(&wolfAsyncSwEventFdLock);
+    *fd = wolfAsyncSwEventFd;
+    pthread_mutex_unlock(&wolfAsyncSwEventFdLock);
+    return (*fd >= 0) ? 0 : ASYNC_INIT_E;
+#else
+    return NOT_COMPILED_IN;
+#endif
+}
+
+int wolfAsync_DevAckEventFd(int devId)
+{
+    if (devId < 0) {
+        return BAD_FUNC_ARG;
+    }
+
+#if defined(HAVE_INTEL_QA)
+    return IntelQaAckEventFd(devId);
+#elif defined(WOLFSSL_ASYNC_CRYPT_SW)
+    {
+        word64 val;
+        pthread_mutex_lock(&wolfAsyncSwEventFdLock);
+        if (wolfAsyncSwEventFd >= 0) {
+            /* clear counter, then allow next push or poll to signal */
+            if (read(wolfAsyncSwEventFd, &val, sizeof(val)) != sizeof(val)) {
+                /* not signaled */
+            }
+            __atomic_store_n(&wolfAsyncSwEventFdSignaled, 0,
+                                                        __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&wolfAsyncSwEventFdLock);
+        return 0;
+    }
+#else
+    return NOT_COMPILED_IN;
+#endif
+}
+#endif /* WC_ASYNC_EVENTFD */
+
+/* called from `wolfSSL_AsyncPop` to check if event is done and deliver
+ * async return code */
+int wolfAsync_EventPop(WOLF_EVENT* event, enum WOLF_EVENT_TYPE event_type)
+{
+    int ret;
+
+    if (event == NULL) {
+        return BAD_FUNC_ARG;
+    }
+
+    if (event->type == event_type) {
+        /* Trap the scenario where event is not done */
+        if (event->state == WOLF_EVENT_STATE_PENDING) {
+            return WC_PENDING_E;
+        }
+
+        /* Get async return code */
+        ret = event->ret;
+
+        /* Reset state */
+        event->state = WOLF_EVENT_STATE_READY;
+    }
+    else {
+        ret = WC_NO_PENDING_E;
+    }
+
+    return ret;
+}
+
+#ifdef WC_ASYNC_COMPLETION_RING
+/* -------------------------------------------------------------------------- */
+/* Completion Ring */
+/* -------------------------------------------------------------------------- */
+
+/* Bounded multi-producer / single-consumer ring of completed events. Producers
+ * are the backend completion paths (QAT callbacks and SW pool workers). The
+ * consumer is whoever holds the queue lock. A device is only tracked by the
+ * ring while the number of tracked devices is below the ring size, so a push
+ * can never find the ring full. Tracking changes and ring lookups are done with
+ * the queue lock held, so the ring can be freed under it once no device is
+ * tracked. Freeing a ring and freeing a tracked device also hold the global
+ * ring lock (taken before the queue lock), so a device never reaches a freed
+ * ring through its owner pointer. */
+
+/* queue to ring mapping, allocated per queue and reused once a ring is freed,
+ * so lookups for other queues never see a freed entry. Entries are freed by
+ * wolfAsync_HardwareStop */
+typedef struct WC_ASYNC_RING_ENTRY {
+    struct WC_ASYNC_RING_ENTRY* next;
+    WOLF_EVENT_QUEUE*   queue;
+    WC_ASYNC_RING*      ring;
+} WC_ASYNC_RING_ENTRY;
+
+static WC_ASYNC_RING_ENTRY* g_asyncRings = NULL;
+#ifndef SINGLE_THREADED
+/* held while adding, freeing or releasing through a ring */
+static pthread_mutex_t g_asyncRingLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* called with queue lock held */
+static WC_ASYNC_RING* wolfAsync_RingFind(WOLF_EVENT_QUEUE* queue)
+{
+    WC_ASYNC_RING_ENTRY* entry;
+
+    for (entry = __atomic_load_n(&g_asyncRings, __ATOMIC_ACQUIRE);
+                                        entry != NULL; entry = entry->next) {
+        if (__atomic_load_n(&entry->queue, __ATOMIC_ACQUIRE) == queue) {
+            return entry->ring;
+        }
+    }
+    return NULL;
+}
+
+static int wolfAsync_RingPush(WC_ASYNC_RING* ring, WOLF_EVENT* event)
+{
+    WC_ASYNC_RING_SLOT* slot;
+    word32 pos, seq;
+    int diff;
+
+    pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    for (;;) {
+        slot = &ring->slots[pos & (ring->size - 1)];
+        seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        diff = (int)(seq - pos);
+        if (diff == 0) {
+            /* slot is free, try to claim it (updates pos on failure) */
+            if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return BUFFER_E; /* full */
+        }
+        else {
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->event = event;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+static WOLF_EVENT* wolfAsync_RingPop(WC_ASYNC_RING* ring)
+{
+    WC_ASYNC_RING_SLOT* slot = &ring->slots[ring->tail & (ring->size - 1)];
+    word32 seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    WOLF_EVENT* event;
+
+    if ((int)(seq - (ring->tail + 1)) < 0) {
+        return NULL; /* empty */
+    }
+
+    event = slot->event;
+    __atomic_store_n(&slot->seq, ring->tail + ring->size, __ATOMIC_RELEASE);
+    ring->tail++;
+
+    return event;
+}
+
+/* returns 1 if backend already finished the operation for this device */
+static int wolfAsync_RingDevIsDone(WC_ASYNC_DEV* asyncDev)
+{
+#ifdef HAVE_INTEL_QA
+    return __atomic_load_n(&asyncDev->qat.ret, __ATOMIC_SEQ_CST) !=
+                                                                WC_PENDING_E;
+#else
+    int state = __atomic_load_n(&asyncDev->sw.poolState, __ATOMIC_SEQ_CST);
+    return state == ASYNC_SW_POOL_COMPLETE || state == ASYNC_SW_POOL_DONE;
+#endif
+}
+
+/* called by backend when operation for device is done */
+void wolfAsync_EventComplete(WC_ASYNC_DEV* asyncDev)
+{
+    WC_ASYNC_RING* ring;
+    WOLF_EVENT* event;
+
+    if (asyncDev == NULL) {
+        return;
+    }
+
+    /* only one completion is pushed per queued event */
+    ring = __atomic_load_n(&asyncDev->ring, __ATOMIC_SEQ_CST);
+    if (ring != NULL && __atomic_compare_exchange_n(&asyncDev->ring, &ring,
+                        NULL, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+        event = asyncDev->ringEvent;
+        /* cannot be full, since tracked count is limited to ring size */
+        (void)wolfAsync_RingPush(ring, event);
+    }
+}
+
+/* track queued event, called with queue lock held. Returns ring the backend
+ * pushes the event to when done, NULL if it is found by the queue scan */
+static WC_ASYNC_RING* wolfAsync_RingTrack(WOLF_EVENT_QUEUE* queue,
+    WOLF_EVENT* event, int canTrack)
+{
+    WC_ASYNC_RING* ring = wolfAsync_RingFind(queue);
+    WC_ASYNC_DEV* asyncDev = event->dev.async;
+#if defined(HAVE_INTEL_QA) && !defined(QAT_USE_POLLING_THREAD)
+    int devId;
+#endif
+
+    if (ring == NULL) {
+        return NULL;
+    }
+#if defined(HAVE_INTEL_QA) && !defined(QAT_USE_POLLING_THREAD)
+    devId = (asyncDev != NULL) ? asyncDev->qat.devId : -1;
+    if (devId < 0 || devId >= QAT_POLL_MAX_INSTANCES) {
+        canTrack = 0; /* instance could not be polled from ring */
+    }
+#endif
+    if (asyncDev == NULL || !canTrack || ring->count >= ring->size) {
+        ring->untracked++;
+        return NULL;
+    }
+
+    ring->count++;
+#if defined(HAVE_INTEL_QA) && !defined(QAT_USE_POLLING_THREAD)
+    ring->inst[devId]++;
+#endif
+    asyncDev->ringOwner = ring;
+    asyncDev->ringEvent = event;
 
-    return ret;
+    return ring;
 }
 
-int wolfAsync_HardwareStart(void)
+/* event is no longer returned through ring, called with queue lock held */
+static void wolfAsync_RingRelease(WC_ASYNC_RING* ring, WC_ASYNC_DEV* asyncDev)
 {
-    int ret = 0;
+    ring->count--;
+#if defined(HAVE_INTEL_QA) && !defined(QAT_USE_POLLING_THREAD)
+    ring->inst[asyncDev->qat.devId]--;
+#endif
+    asyncDev->ringOwner = NULL;
+    asyncDev->ringEvent = NULL;
+}
 
-    #ifdef HAVE_CAVIUM
-        /* nothing to do */
-    #elif defined(HAVE_INTEL_QA)
-        ret = IntelQaHardwareStart(QAT_PROCESS_NAME, QAT_LIMIT_DEV_ACCESS);
-    #endif
+/* take still queued event back from ring, called with queue lock held. A
+ * completion already pushed (or being pushed) is removed from the ring, so the
+ * ring never holds an event it does not track */
+static void wolfAsync_RingUntrack(WC_ASYNC_DEV* asyncDev)
+{
+    WC_ASYNC_RING* ring = asyncDev->ringOwner;
+    WOLF_EVENT* event = asyncDev->ringEvent;
+    WOLF_EVENT* done;
+    word32 i;
 
-    return ret;
+    if (ring == NULL) {
+        return;
+    }
+
+    /* disarm, if already taken the backend has pushed it (or is about to) */
+    if (__atomic_exchange_n(&asyncDev->ring, NULL, __ATOMIC_SEQ_CST) == NULL) {
+        for (;;) {
+            for (i = 0; i < ring->readyCount; i++) {
+                if (ring->ready[i] == event) {
+                    break;
+                }
+            }
+            if (i < ring->readyCount) {
+                XMEMMOVE(&ring->ready[i], &ring->ready[i + 1],
+                    (ring->readyCount - i - 1) * sizeof(WOLF_EVENT*));
+                ring->readyCount--;
+                break;
+            }
+            done = wolfAsync_RingPop(ring);
+            if (done != NULL) {
+                ring->ready[ring->readyCount++] = done;
+            }
+            else {
+            #ifndef WC_NO_ASYNC_THREADING
+                wc_AsyncThreadYield();
+            #endif
+            }
+        }
+    }
+
+    wolfAsync_RingRelease(ring, asyncDev);
+    /* left in queue, now found by queue scan */
+    ring->untracked++;
 }
 
-void wolfAsync_HardwareStop(void)
+/* device is being freed, stop ring from returning its event */
+static void wolfAsync_RingDevFree(WC_ASYNC_DEV* asyncDev)
 {
-    #ifdef HAVE_CAVIUM
-        /* nothing to do */
-    #elif defined(HAVE_INTEL_QA)
-        IntelQaHardwareStop();
+    WC_ASYNC_RING* ring;
+#ifndef SINGLE_THREADED
+    WOLF_EVENT_QUEUE* queue;
+#endif
+
+    /* device with nothing queued is never tracked by a ring */
+    if (__atomic_load_n(&asyncDev->ringOwner, __ATOMIC_ACQUIRE) == NULL) {
+        return;
+    }
+
+#ifndef SINGLE_THREADED
+    /* ring (and its queue) cannot be freed while this is held */
+    pthread_mutex_lock(&g_asyncRingLock);
+#endif
+    ring = __atomic_load_n(&asyncDev->ringOwner, __ATOMIC_ACQUIRE);
+    if (ring != NULL) {
+    #ifndef SINGLE_THREADED
+        queue = ring->queue;
+        if (wc_LockMutex(&queue->lock) == 0) {
+    #endif
+            /* may have been returned by a poll on another thread meanwhile */
+            if (asyncDev->ringOwner == ring) {
+                wolfAsync_RingUntrack(asyncDev);
+            }
+    #ifndef SINGLE_THREADED
+            wc_UnLockMutex(&queue->lock);
+        }
     #endif
+    }
+#ifndef SINGLE_THREADED
+    pthread_mutex_unlock(&g_asyncRingLock);
+#endif
 }
 
-int wolfAsync_DevOpen(int *devId)
+/* free queue to ring mapping entries, only once no queue has a ring */
+static void wolfAsync_RingCleanup(void)
 {
-    return wolfAsync_DevOpenThread(devId, NULL);
-}
+    WC_ASYNC_RING_ENTRY* entry;
+    WC_ASYNC_RING_ENTRY* next;
 
-void wolfAsync_DevClose(int *devId)
-{
-    if (devId && *devId != INVALID_DEVID) {
-    #ifdef HAVE_CAVIUM
-        NitroxCloseDevice(*devId);
-    #elif defined(HAVE_INTEL_QA)
-        IntelQaDeInit(*devId);
-    #endif
-        *devId = INVALID_DEVID;
+#ifndef SINGLE_THREADED
+    pthread_mutex_lock(&g_asyncRingLock);
+#endif
+    for (entry = g_asyncRings; entry != NULL; entry = entry->next) {
+        if (__atomic_load_n(&entry->queue, __ATOMIC_ACQUIRE) != NULL) {
+            break; /* ring not freed, keep all for its lookups */
+        }
+    }
+    if (entry == NULL) {
+        entry = __atomic_exchange_n(&g_asyncRings, NULL, __ATOMIC_ACQ_REL);
+        while (entry != NULL) {
+            next = entry->next;
+            XFREE(entry, NULL, DYNAMIC_TYPE_ASYNC);
+            entry = next;
+        }
     }
+#ifndef SINGLE_THREADED
+    pthread_mutex_unlock(&g_asyncRingLock);
+#endif
 }
 
-int wolfAsync_DevCtxInit(WC_ASYNC_DEV* asyncDev, word32 marker, void* heap,
-    int devId)
+int wolfAsync_EventQueueRingInit(WOLF_EVENT_QUEUE* queue, word32 size,
+    void* heap)
 {
     int ret = 0;
+    word32 n;
+    WC_ASYNC_RING* ring;
+    WC_ASYNC_RING_ENTRY* entry;
+    WC_ASYNC_RING_ENTRY* head;
+    WOLF_EVENT* event;
 
-    if (asyncDev == NULL) {
+    if (queue == NULL) {
         return BAD_FUNC_ARG;
     }
 
-    /* always clear async device context */
-    XMEMSET(asyncDev, 0, sizeof(WC_ASYNC_DEV));
+    if (size == 0) {
+        size = WC_ASYNC_RING_SIZE;
+    }
+    /* round up to power of 2 */
+    for (n = 1; n < size && n < 0x80000000UL; n <<= 1);
+    size = n;
+
+    ring = (WC_ASYNC_RING*)XMALLOC(sizeof(WC_ASYNC_RING) +
+        (size * sizeof(WC_ASYNC_RING_SLOT)) + (size * sizeof(WOLF_EVENT*)),
+        heap, DYNAMIC_TYPE_ASYNC);
+    if (ring == NULL) {
+        return MEMORY_E;
+    }
+    XMEMSET(ring, 0, sizeof(WC_ASYNC_RING));
+    ring->queue = queue;
+    ring->heap = heap;
+    ring->size = size;
+    ring->slots = (WC_ASYNC_RING_SLOT*)&ring[1];
+    ring->ready = (WOLF_EVENT**)&ring->slots[size];
+    for (n = 0; n < size; n++) {
+        ring->slots[n].seq = n;
+        ring->slots[n].event = NULL;
+    }
 
-    /* negative device Id's are invalid */
-    if (devId >= 0) {
-        asyncDev->marker = marker;
-        asyncDev->heap = heap;
+#ifndef SINGLE_THREADED
+    pthread_mutex_lock(&g_asyncRingLock);
+    if ((ret = wc_LockMutex(&queue->lock)) != 0) {
+        pthread_mutex_unlock(&g_asyncRingLock);
+        XFREE(ring, heap, DYNAMIC_TYPE_ASYNC);
+        return ret;
+    }
+#endif
 
-    #ifdef HAVE_CAVIUM
-        ret = NitroxAllocContext(asyncDev, devId, CONTEXT_SSL);
-    #elif defined(HAVE_INTEL_QA)
-        ret = IntelQaOpen(asyncDev, devId);
-    #endif
+    if (wolfAsync_RingFind(queue) != NULL) {
+        /* already setup */
+        XFREE(ring, heap, DYNAMIC_TYPE_ASYNC);
+        ring = NULL;
+    }
+    else {
+        /* events already queued are found by queue scan */
+        for (event = queue->head; event != NULL; event = event->next) {
+            ring->untracked++;
+        }
+
+        /* reuse an entry from a freed ring, otherwise add one */
+        for (entry = __atomic_load_n(&g_asyncRings, __ATOMIC_ACQUIRE);
+                                        entry != NULL; entry = entry->next) {
+            head = NULL;
+            if (__atomic_compare_exchange_n(&entry->queue, &head, queue, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+        if (entry == NULL) {
+            entry = (WC_ASYNC_RING_ENTRY*)XMALLOC(sizeof(WC_ASYNC_RING_ENTRY),
+                NULL, DYNAMIC_TYPE_ASYNC);
+            if (entry == NULL) {
+                ret = MEMORY_E;
+            }
+            else {
+                entry->queue = queue;
+                entry->ring = ring;
+                head = __atomic_load_n(&g_asyncRings, __ATOMIC_RELAXED);
+                do {
+                    entry->next = head;
+                } while (!__atomic_compare_exchange_n(&g_asyncRings, &head,
+                            entry, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+            }
+        }
+        else {
+            entry->ring = ring;
+        }
+    }
+
+#ifndef SINGLE_THREADED
+    wc_UnLockMutex(&queue->lock);
+    pthread_mutex_unlock(&g_asyncRingLock);
+#endif
+
+    if (ret != 0) {
+        XFREE(ring, heap, DYNAMIC_TYPE_ASYNC);
     }
 
     return ret;
 }
 
-void wolfAsync_DevCtxFree(WC_ASYNC_DEV* asyncDev, word32 marker)
+/* events still queued are returned by the normal queue scan afterwards */
+void wolfAsync_EventQueueRingFree(WOLF_EVENT_QUEUE* queue)
 {
-    if (asyncDev && asyncDev->marker == marker) {
-    #ifdef HAVE_CAVIUM
-        NitroxFreeContext(asyncDev);
-    #elif defined(HAVE_INTEL_QA)
-        IntelQaClose(asyncDev);
-    #endif
-        asyncDev->marker = WOLFSSL_ASYNC_MARKER_INVALID;
+    WC_ASYNC_RING_ENTRY* entry;
+    WC_ASYNC_RING* ring = NULL;
+    WOLF_EVENT* event;
+
+    if (queue == NULL) {
+        return;
     }
-}
 
-int wolfAsync_DevCopy(WC_ASYNC_DEV* src, WC_ASYNC_DEV* dst)
-{
-    int ret = 0;
+#ifndef SINGLE_THREADED
+    /* a device being freed may be about to release through this ring */
+    pthread_mutex_lock(&g_asyncRingLock);
+    if (wc_LockMutex(&queue->lock) != 0) {
+        pthread_mutex_unlock(&g_asyncRingLock);
+        return;
+    }
+#endif
 
-    if (src == NULL || dst == NULL)
-        return BAD_FUNC_ARG;
+    for (entry = __atomic_load_n(&g_asyncRings, __ATOMIC_ACQUIRE);
+                                        entry != NULL; entry = entry->next) {
+        if (__atomic_load_n(&entry->queue, __ATOMIC_ACQUIRE) == queue) {
+            ring = entry->ring;
+            entry->ring = NULL;
+            __atomic_store_n(&entry->queue, NULL, __ATOMIC_RELEASE);
+            break;
+        }
+    }
 
-    /* make sure we aren't copying to self */
-    if (src == dst)
-        return ret;
+    /* take back tracked events, so no backend can push to the ring */
+    if (ring != NULL) {
+        for (event = queue->head; event != NULL; event = event->next) {
+            if (event->dev.async != NULL &&
+                                    event->dev.async->ringOwner == ring) {
+                wolfAsync_RingUntrack(event->dev.async);
+            }
+        }
+    }
 
-#ifdef HAVE_CAVIUM
-    /* nothing to do here */
-#elif defined(HAVE_INTEL_QA)
-    ret = IntelQaDevCopy(src, dst);
+#ifndef SINGLE_THREADED
+    wc_UnLockMutex(&queue->lock);
 #endif
 
-    return ret;
+    if (ring != NULL) {
+        XFREE(ring, ring->heap, DYNAMIC_TYPE_ASYNC);
+    }
+#ifndef SINGLE_THREADED
+    pthread_mutex_unlock(&g_asyncRingLock);
+#endif
 }
 
-/* called from `wolfSSL_AsyncPop` to check if event is done and deliver
- * async return code */
-int wolfAsync_EventPop(WOLF_EVENT* event, enum WOLF_EVENT_TYPE event_type)
+/* return completed ring events, called with queue lock held */
+static int wolfAsync_RingHarvest(WC_ASYNC_RING* ring, void* context_filter,
+    WOLF_EVENT** events, int maxEvents, int* eventCount)
 {
-    int ret;
+    int ret = 0, count = 0;
+    word32 i, keep = 0;
+    WOLF_EVENT* event;
+    WC_ASYNC_DEV* asyncDev;
 
-    if (event == NULL) {
-        return BAD_FUNC_ARG;
+    /* move completed events from ring to ready list */
+    while (ring->readyCount < ring->size &&
+                                (event = wolfAsync_RingPop(ring)) != NULL) {
+        ring->ready[ring->readyCount++] = event;
     }
 
-    if (event->type == event_type) {
-        /* Trap the scenario where event is not done */
-        if (event->state == WOLF_EVENT_STATE_PENDING) {
-            return WC_PENDING_E;
+    for (i = 0; i < ring->readyCount; i++) {
+        event = ring->ready[i];
+        asyncDev = event->dev.async;
+
+        /* keep events that do not match filter or do not fit */
+        if (ret < 0 || (events && count >= maxEvents) ||
+            (context_filter != NULL && event->context != context_filter)) {
+            ring->ready[keep++] = event;
+            continue;
         }
 
-        /* Get async return code */
-        ret = event->ret;
+        /* run cleanup and deliver result on thread that owns the event */
+        if (event->ret == WC_PENDING_E) {
+        #ifdef HAVE_INTEL_QA
+            IntelQaOpFinish(asyncDev);
+        #else
+            event->ret = wolfAsync_SwPoolRun(asyncDev);
+        #endif
+        }
+        if (event->ret == WC_PENDING_E) {
+            ring->ready[keep++] = event;
+            continue;
+        }
+        event->state = WOLF_EVENT_STATE_DONE;
 
-        /* Reset state */
-        event->state = WOLF_EVENT_STATE_READY;
-    }
-    else {
-        ret = WC_NO_PENDING_E;
+        /* remove from queue */
+        ret = wolfEventQueue_Remove(ring->queue, event);
+        if (ret < 0) {
+            ring->ready[keep++] = event;
+            continue;
+        }
+        wolfAsync_RingRelease(ring, asyncDev);
+
+        /* return pointer in 'events' arg */
+        if (events) {
+            events[count] = event;
+        }
+        count++;
     }
+    ring->readyCount = keep;
+
+    *eventCount = count;
 
     return ret;
 }
+#endif /* WC_ASYNC_COMPLETION_RING */
 
 int wolfAsync_EventQueuePush(WOLF_EVENT_QUEUE* queue, WOLF_EVENT* event)
 {
+    int ret;
+#ifdef WC_ASYNC_COMPLETION_RING
+    WC_ASYNC_RING* ring = NULL;
+#endif
+#ifdef WC_ASYNC_SW_THREADS
+    int swQueued = 0;
+#endif
+
     if (queue == NULL) {
         return BAD_FUNC_ARG;
     }
 
     /* Setup event and push to event queue */
     event->dev.async = wolfAsync_GetDev(event);
-    return wolfEventQueue_Push(queue, event);
+
+#ifdef WC_ASYNC_COMPLETION_RING
+    /* ring is only looked up and tracked with queue locked */
+    #ifndef SINGLE_THREADED
+    if ((ret = wc_LockMutex(&queue->lock)) != 0) {
+        return ret;
+    }
+    #endif
+    ret = wolfEventQueue_Add(queue, event);
+#else
+    ret = wolfEventQueue_Push(queue, event);
+#endif
+
+#ifdef WC_ASYNC_SW_THREADS
+    /* start SW work now, the worker signals when done */
+    if (ret == 0 && wolfAsync_SwPoolSubmit(event->dev.async) == 0) {
+        swQueued = 1;
+    }
+#endif
+
+#ifdef WC_ASYNC_COMPLETION_RING
+    if (ret == 0) {
+    #ifdef WC_ASYNC_SW_THREADS
+        /* only pooled work is completed without the poller */
+        ring = wolfAsync_RingTrack(queue, event, swQueued);
+    #else
+        ring = wolfAsync_RingTrack(queue, event, 1);
+    #endif
+    }
+    if (ring != NULL) {
+        /* enable completion push, operation may already be done */
+        __atomic_store_n(&event->dev.async->ring, ring, __ATOMIC_SEQ_CST);
+        if (wolfAsync_RingDevIsDone(event->dev.async)) {
+            wolfAsync_EventComplete(event->dev.async);
+        }
+    }
+    #ifndef SINGLE_THREADED
+    wc_UnLockMutex(&queue->lock);
+    #endif
+#endif
+
+#if defined(WOLFSSL_ASYNC_CRYPT_SW) && defined(WC_ASYNC_EVENTFD)
+    /* SW work is done by the poller, so wake it */
+    #ifdef WC_ASYNC_SW_THREADS
+    if (ret == 0 && !swQueued)
+    #else
+    if (ret == 0)
+    #endif
+    {
+        wolfAsync_SwEventFdSignal();
+    }
+#endif
+
+    return ret;
 }
 
 #ifdef HAVE_CAVIUM
@@ -504,6 +2475,15 @@ static int wolfAsync_NitroxCheckReq(WC_ASYNC_DEV* asyncDev, WOLF_EVENT* event)
 }
 #endif /* HAVE_CAVIUM */
 
+/* mark event as done and signal completion ring (if used) */
+static void wolfAsync_EventSetDone(WOLF_EVENT* event)
+{
+    event->state = WOLF_EVENT_STATE_DONE;
+#ifdef WC_ASYNC_COMPLETION_RING
+    wolfAsync_EventComplete(event->dev.async);
+#endif
+}
+
 int wolfAsync_EventPoll(WOLF_EVENT* event, WOLF_EVENT_FLAG flags)
 {
     int ret = 0;
@@ -525,13 +2505,15 @@ int wolfAsync_EventPoll(WOLF_EVENT* event, WOLF_EVENT_FLAG flags)
     #elif defined(HAVE_INTEL_QA)
         /* poll QAT hardware, callback returns data, IntelQaPoll sets event */
         ret = IntelQaPoll(asyncDev);
+    #elif defined(WC_ASYNC_SW_THREADS)
+        event->ret = wolfAsync_SwPoolRun(asyncDev);
     #elif defined(WOLFSSL_ASYNC_CRYPT_SW)
         event->ret = wolfAsync_DoSw(asyncDev);
     #endif
 
         /* If not pending then mark as done */
         if (event->ret != WC_PENDING_E) {
-            event->state = WOLF_EVENT_STATE_DONE;
+            wolfAsync_EventSetDone(event);
         }
     }
 
@@ -583,7 +2565,7 @@ static int wolfAsync_NitroxCheckMultiReqBuf(WC_ASYNC_DEV* asyncDev,
 
                         /* If not pending then mark as done */
                         if (event->ret != WC_PENDING_E) {
-                            event->state = WOLF_EVENT_STATE_DONE;
+                            wolfAsync_EventSetDone(event);
                             event->reqId = 0;
                         }
                         break;
@@ -607,6 +2589,19 @@ int wolfAsync_EventQueuePoll(WOLF_EVENT_QUEUE* queue, void* context_filter,
     WOLF_EVENT* event;
     int ret = 0, count = 0;
     WC_ASYNC_DEV* asyncDev = NULL;
+#ifdef WC_ASYNC_COMPLETION_RING
+    WC_ASYNC_RING* ring;
+#endif
+#if defined(HAVE_INTEL_QA) && !defined(QAT_USE_POLLING_THREAD)
+    int devId, pollRet, pollErr = 0;
+    word32 polled[(QAT_POLL_MAX_INSTANCES + 31) / 32];
+#ifdef WC_ASYNC_COMPLETION_RING
+    int devCount;
+#endif
+#endif
+#if defined(WOLFSSL_ASYNC_CRYPT_SW) && defined(WC_ASYNC_EVENTFD)
+    int swPending = 0;
+#endif
 #if defined(HAVE_CAVIUM)
     CspMultiRequestStatusBuffer multi_req;
     int req_count = 0;
@@ -630,8 +2625,74 @@ int wolfAsync_EventQueuePoll(WOLF_EVENT_QUEUE* queue, void* context_filter,
     }
 #endif
 
+#ifdef WC_ASYNC_COMPLETION_RING
+    ring = wolfAsync_RingFind(queue);
+#endif
+
     if (flags & WOLF_POLL_FLAG_CHECK_HW) {
+    #if defined(HAVE_INTEL_QA) && !defined(QAT_USE_POLLING_THREAD)
+        /* poll each QAT instance with pending events only once, the callbacks
+         * for all devices on that instance are run */
+        XMEMSET(polled, 0, sizeof(polled));
+        #ifdef WC_ASYNC_COMPLETION_RING
+        if (ring != NULL) {
+            /* ring counts tracked devices per instance, no queue walk */
+            devCount = IntelQaGetCyInstanceCount();
+            if (devCount > QAT_POLL_MAX_INSTANCES) {
+                devCount = QAT_POLL_MAX_INSTANCES;
+            }
+            for (devId = 0; devId < devCount; devId++) {
+                if (ring->inst[devId] == 0) {
+                    continue;
+                }
+                polled[devId / 32] |= (1U << (devId % 32));
+                pollRet = IntelQaPollInstance(devId);
+                if (pollRet != 0 && pollErr == 0) {
+                    pollErr = pollRet; /* keep polling the others */
+                }
+            }
+        }
+        /* events not tracked by ring are found by queue walk */
+        if (ring == NULL || ring->untracked > 0)
+        #endif
+        for (event = queue->head; event != NULL; event = event->next) {
+            if (event->type >= WOLF_EVENT_TYPE_ASYNC_FIRST &&
+                event->type <= WOLF_EVENT_TYPE_ASYNC_LAST &&
+                (context_filter == NULL || event->context == context_filter) &&
+                event->dev.async != NULL)
+            {
+            #ifdef WC_ASYNC_COMPLETION_RING
+                if (event->dev.async->ringOwner != NULL) {
+                    continue; /* instance polled above */
+                }
+            #endif
+                devId = event->dev.async->qat.devId;
+                if (devId >= 0 && devId < QAT_POLL_MAX_INSTANCES) {
+                    if (polled[devId / 32] & (1U << (devId % 32))) {
+                        continue; /* already polled */
+                    }
+                    polled[devId / 32] |= (1U << (devId % 32));
+                }
+                pollRet = IntelQaPollDev(event->dev.async);
+                if (pollRet != 0 && pollErr == 0) {
+                    pollErr = pollRet; /* keep polling the others */
+                }
+            }
+        }
+    #endif
+
+    #ifdef WC_ASYNC_SW_ECDH_BATCH
+        wolfAsync_SwEcdhBatch(queue, context_filter);
+    #endif
+    #ifdef WC_ASYNC_SW_POLL_BUDGET
+        wolfAsync_SwRunBudget(queue, context_filter);
+    #endif
+
         /* check event queue */
+    #ifdef WC_ASYNC_COMPLETION_RING
+        /* tracked events are finished when harvested from ring */
+        if (ring == NULL || ring->untracked > 0)
+    #endif
         for (event = queue->head; event != NULL; event = event->next) {
             if (event->type >= WOLF_EVENT_TYPE_ASYNC_FIRST &&
                 event->type <= WOLF_EVENT_TYPE_ASYNC_LAST)
@@ -644,6 +2705,11 @@ int wolfAsync_EventQueuePoll(WOLF_EVENT_QUEUE* queue, void* context_filter,
                         ret = WC_INIT_E;
                         break;
                     }
+                #ifdef WC_ASYNC_COMPLETION_RING
+                    if (asyncDev->ringOwner != NULL) {
+                        continue;
+                    }
+                #endif
 
                     count++;
 
@@ -665,11 +2731,9 @@ int wolfAsync_EventQueuePoll(WOLF_EVENT_QUEUE* queue, void* context_filter,
                     }
             #else
                 #if defined(HAVE_INTEL_QA)
-                    /* poll QAT hardware, callback returns data, IntelQaPoll sets event */
-                    ret = IntelQaPoll(asyncDev);
-                    if (ret != 0) {
-                        break;
-                    }
+                    /* instance polled above (or by polling thread), callback
+                     * returned data, IntelQaOpFinish sets event */
+                    IntelQaOpFinish(asyncDev);
 
                 #elif defined(WOLFSSL_ASYNC_CRYPT_SW)
                     #ifdef WOLF_ASYNC_SW_SKIP_MOD
@@ -677,7 +2741,13 @@ int wolfAsync_EventQueuePoll(WOLF_EVENT_QUEUE* queue, void* context_filter,
                         if (count % WOLF_ASYNC_SW_SKIP_MOD)
                     #endif
                         {
+                        #ifdef WC_ASYNC_SW_THREADS
+                            event->ret = wolfAsync_SwPoolRun(asyncDev);
+                        #elif defined(WC_ASYNC_SW_POLL_BUDGET)
+                            /* stepped by wolfAsync_SwRunBudget above */
+                        #else
                             event->ret = wolfAsync_DoSw(asyncDev);
+                        #endif
                         }
                 #elif defined(WOLF_CRYPTO_CB) || defined(HAVE_PK_CALLBACKS)
                     /* Use crypto or PK callbacks */
@@ -688,13 +2758,33 @@ int wolfAsync_EventQueuePoll(WOLF_EVENT_QUEUE* queue, void* context_filter,
 
                     /* If not pending then mark as done */
                     if (event->ret != WC_PENDING_E) {
-                        event->state = WOLF_EVENT_STATE_DONE;
+                        wolfAsync_EventSetDone(event);
+                    }
+                #if defined(WOLFSSL_ASYNC_CRYPT_SW) && defined(WC_ASYNC_EVENTFD)
+                #ifdef WC_ASYNC_SW_THREADS
+                    /* pooled work is signaled by the worker */
+                    else if (__atomic_load_n(&asyncDev->sw.poolState,
+                                    __ATOMIC_ACQUIRE) == ASYNC_SW_POOL_IDLE) {
+                        swPending = 1;
+                    }
+                #else
+                    else {
+                        swPending = 1;
                     }
+                #endif
+                #endif
             #endif
                 }
             }
         } /* for */
 
+    #if defined(WOLFSSL_ASYNC_CRYPT_SW) && defined(WC_ASYNC_EVENTFD)
+        /* SW work left over, keep the descriptor readable */
+        if (swPending) {
+            wolfAsync_SwEventFdSignal();
+        }
+    #endif
+
     #if defined(HAVE_CAVIUM)
         /* submit partial multi-request query (if no prev errors) */
         if (ret == 0 && req_count > 0) {
@@ -706,6 +2796,15 @@ int wolfAsync_EventQueuePoll(WOLF_EVENT_QUEUE* queue, void* context_filter,
 
     /* process event queue */
     count = 0;
+#ifdef WC_ASYNC_COMPLETION_RING
+    /* only completed events are visited, unless some were not tracked */
+    if (ring != NULL) {
+        ret = wolfAsync_RingHarvest(ring, context_filter, events, maxEvents,
+            &count);
+    }
+    if (ring == NULL || (ret == 0 && (events == NULL || count < maxEvents) &&
+                                                        ring->untracked > 0))
+#endif
     for (event = queue->head; event != NULL; event = event->next) {
         if (event->type >= WOLF_EVENT_TYPE_ASYNC_FIRST &&
             event->type <= WOLF_EVENT_TYPE_ASYNC_LAST)
@@ -714,9 +2813,22 @@ int wolfAsync_EventQueuePoll(WOLF_EVENT_QUEUE* queue, void* context_filter,
             if (context_filter == NULL || event->context == context_filter) {
                 /* If event is done then process */
                 if (event->state == WOLF_EVENT_STATE_DONE) {
+                #ifdef WC_ASYNC_COMPLETION_RING
+                    /* tracked events are returned from ring */
+                    if (event->dev.async != NULL &&
+                                        event->dev.async->ringOwner != NULL) {
+                        continue;
+                    }
+                #endif
+
                     /* remove from queue */
                     ret = wolfEventQueue_Remove(queue, event);
                     if (ret < 0) break; /* exit for */
+                #ifdef WC_ASYNC_COMPLETION_RING
+                    if (ring != NULL && ring->untracked > 0) {
+                        ring->untracked--;
+                    }
+                #endif
 
                     /* return pointer in 'events' arg */
                     if (events) {
@@ -737,6 +2849,13 @@ int wolfAsync_EventQueuePoll(WOLF_EVENT_QUEUE* queue, void* context_filter,
     wc_UnLockMutex(&queue->lock);
 #endif
 
+#if defined(HAVE_INTEL_QA) && !defined(QAT_USE_POLLING_THREAD)
+    /* first instance poll failure, once every instance was polled */
+    if (ret == 0) {
+        ret = pollErr;
+    }
+#endif
+
     /* Return number of properly populated events */
     if (eventCount) {
         *eventCount = count;
@@ -804,7 +2923,7 @@ int wc_AsyncHandle(WC_ASYNC_DEV* asyncDev, WOLF_EVENT_QUEUE* queue,
     ret = wolfAsync_EventInit(event, WOLF_EVENT_TYPE_ASYNC_WOLFCRYPT,
                                                         asyncDev, event_flags);
     if (ret == 0) {
-        ret = wolfEventQueue_Push(queue, event);
+        ret = wolfAsync_EventQueuePush(queue, event);
     }
 
     /* check for error (helps with debugging) */
@@ -71,6 +71,16 @@
 #endif
 
 #include <pthread.h>
+#if !defined(QAT_NO_NUMA_AFFINITY) && defined(__linux__)
+    #include <unistd.h>
+    #include <sys/syscall.h>
+#endif
+#ifdef WC_ASYNC_EVENTFD
+    #include <unistd.h>
+    #ifdef QAT_USE_POLLING_THREAD
+        #include <sys/eventfd.h>
+    #endif
+#endif
 
 /* Async enables (1=non-block, 0=block) */
 #ifndef QAT_RSA_ASYNC
@@ -105,16 +115,32 @@
 
 #define OS_HOST_TO_NW_32(uData) ByteReverseWord32(uData)
 
+/* polling thread and scheduler use number of requests in flight per instance */
+#if (defined(QAT_USE_POLLING_THREAD) || defined(QAT_SCHED_LOAD) || \
+     defined(QAT_SW_FALLBACK)) && !defined(QAT_TRACK_INFLIGHT)
+    #define QAT_TRACK_INFLIGHT
+#endif
+
 static CpaInstanceHandle* g_cyInstances = NULL;
 static CpaInstanceInfo2* g_cyInstanceInfo = NULL;
 static Cpa32U* g_cyInstMap = NULL;
 static Cpa16U g_numInstances = 0;
 static Cpa16U g_instCounter = 0;
+static int* g_cyInstUsers = NULL; /* threads assigned to each instance */
 static CpaBoolean g_cyServiceStarted = CPA_FALSE;
 #ifdef QAT_USE_POLLING_CHECK
     static CpaBoolean* g_cyPolling = NULL;
     static pthread_mutex_t* g_PollLock;
 #endif
+#ifdef QAT_TRACK_INFLIGHT
+    static int* g_cyInFlight = NULL; /* requests submitted per instance */
+#endif
+#ifdef WC_ASYNC_EVENTFD
+    static int* g_cyEventFd = NULL; /* completion notification per instance */
+    #ifdef QAT_USE_POLLING_THREAD
+    static int* g_cyEventFdSignaled = NULL;
+    #endif
+#endif
 static volatile int g_initCount = 0;
 #if defined(HAVE_ECC) && defined(HAVE_ECC_DHE)
     static Cpa8U* g_qatEcdhY = NULL;
@@ -139,6 +165,20 @@ static qatCapabilities_t g_qatCapabilities = {
 
 #if defined(QAT_ENABLE_CRYPTO) || defined(QAT_ENABLE_HASH)
     static int IntelQaSymClose(WC_ASYNC_DEV* dev, int doFree);
+    static int IntelQaDevIsSym(WC_ASYNC_DEV* dev);
+    static CpaBufferList* IntelQaSymListGet(WC_ASYNC_DEV* dev,
+        word32 numBuffers);
+    static void IntelQaSymListFree(WC_ASYNC_DEV* dev);
+#endif
+#ifdef QAT_ENABLE_HASH
+    static int IntelQaSymHashGetInfo(CpaCySymHashAlgorithm hashAlgorithm,
+        Cpa32U* pBlockSize, Cpa32U* pDigestSize);
+    static int IntelQaHashChunksCopy(WC_ASYNC_DEV* src, WC_ASYNC_DEV* dst);
+    static void IntelQaHashChunksFree(WC_ASYNC_DEV* dev);
+#endif
+#if defined(QAT_ENABLE_HASH) && defined(QAT_HASH_ENABLE_PARTIAL)
+    static int IntelQaHashStreamCopy(WC_ASYNC_DEV* src, WC_ASYNC_DEV* dst);
+    static void IntelQaHashStreamFree(WC_ASYNC_DEV* dev);
 #endif
 #if defined(QAT_ENABLE_RNG)
 static int IntelQaDrbgClose(WC_ASYNC_DEV* dev);
@@ -152,44 +192,359 @@ extern Cpa32U osalLogLevelSet(Cpa32U level);
 /* -------------------------------------------------------------------------- */
 
 #ifdef QAT_USE_POLLING_THREAD
+/* polling thread for each instance */
+typedef struct IntelQaPoller {
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    int             devId;
+    volatile int    running;
+    word32          respIntervalUs; /* average time between responses */
+    byte            isInit:1;
+    byte            isStarted:1;
+} IntelQaPoller;
+static IntelQaPoller* g_cyPollers = NULL;
+
+static word64 IntelQaPollTimeUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((word64)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static void IntelQaPollSleepUs(word32 us)
+{
+    struct timespec ts;
+    ts.tv_sec = us / 1000000;
+    ts.tv_nsec = (us % 1000000) * 1000;
+    nanosleep(&ts, NULL);
+}
+
+/* wait until a request is submitted or poller is stopped */
+static void IntelQaPollerWait(IntelQaPoller* poller)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += QAT_POLL_IDLE_WAIT_MS / 1000;
+    ts.tv_nsec += (QAT_POLL_IDLE_WAIT_MS % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+
+    if (pthread_mutex_lock(&poller->lock) == 0) {
+        /* check again with lock held so wakeup is not lost */
+        if (poller->running &&
+              __atomic_load_n(&g_cyInFlight[poller->devId], __ATOMIC_ACQUIRE) <= 0) {
+            pthread_cond_timedwait(&poller->cond, &poller->lock, &ts);
+        }
+        pthread_mutex_unlock(&poller->lock);
+    }
+}
+
+/* called when instance goes from no requests in flight to one */
+static void IntelQaPollerWake(int devId)
+{
+    IntelQaPoller* poller;
+
+    if (g_cyPollers == NULL)
+        return;
+
+    poller = &g_cyPollers[devId];
+    if (pthread_mutex_lock(&poller->lock) == 0) {
+        pthread_cond_signal(&poller->cond);
+        pthread_mutex_unlock(&poller->lock);
+    }
+}
+
 static void* IntelQaPollingThread(void* context)
 {
-    WC_ASYNC_DEV* dev = (WC_ASYNC_DEV*)context;
+    IntelQaPoller* poller = (IntelQaPoller*)context;
+    CpaInstanceHandle handle = g_cyInstances[poller->devId];
+    CpaStatus status;
+    word32 empty = 0, sleepUs;
+    word64 now, lastResp;
+
 #ifdef QAT_DEBUG
-    printf("Polling Thread Start\n");
+    printf("Polling Thread Start: inst %d\n", poller->devId);
 #endif
-    while (dev->qat.pollingCy) {
-        icp_sal_CyPollInstance(dev->qat.handle, QAT_POLL_RESP_QUOTA);
-        wc_AsyncSleep(10);
+
+    lastResp = IntelQaPollTimeUs();
+    while (poller->running) {
+        if (__atomic_load_n(&g_cyInFlight[poller->devId], __ATOMIC_ACQUIRE) <= 0) {
+            /* nothing in flight, sleep until request is submitted */
+            IntelQaPollerWait(poller);
+            empty = 0;
+            lastResp = IntelQaPollTimeUs();
+            continue;
+        }
+
+        status = icp_sal_CyPollInstance(handle, QAT_POLL_RESP_QUOTA);
+        if (status == CPA_STATUS_SUCCESS) {
+            /* responses processed, track average interval between them */
+            now = IntelQaPollTimeUs();
+            poller->respIntervalUs = (word32)(((word64)poller->respIntervalUs * 7 +
+                                                        (now - lastResp)) / 8);
+            lastResp = now;
+            empty = 0;
+            continue;
+        }
+        if (status != CPA_STATUS_RETRY) {
+            printf("IntelQa: Poll failure %d\n", status);
+        }
+
+        /* no responses: spin, then yield, then sleep part of the interval */
+        empty++;
+        if (empty <= QAT_POLL_SPIN_COUNT) {
+            continue;
+        }
+        if (empty <= QAT_POLL_SPIN_COUNT + QAT_POLL_YIELD_COUNT) {
+            sched_yield();
+            continue;
+        }
+        sleepUs = poller->respIntervalUs / 2;
+        if (sleepUs == 0)
+            sleepUs = 1;
+        if (sleepUs > QAT_POLL_SLEEP_MAX_US)
+            sleepUs = QAT_POLL_SLEEP_MAX_US;
+        IntelQaPollSleepUs(sleepUs);
     }
+
 #ifdef QAT_DEBUG
-    printf("Polling Thread Exit\n");
+    printf("Polling Thread Exit: inst %d\n", poller->devId);
 #endif
     pthread_exit(NULL);
 }
 
-static CpaStatus IntelQaStartPollingThread(WC_ASYNC_DEV* dev)
+static void IntelQaStopPollingThreads(void)
+{
+    int i;
+    IntelQaPoller* poller;
+
+    if (g_cyPollers == NULL)
+        return;
+
+    for (i=0; i<g_numInstances; i++) {
+        poller = &g_cyPollers[i];
+        if (poller->isStarted) {
+            if (pthread_mutex_lock(&poller->lock) == 0) {
+                poller->running = 0;
+                pthread_cond_signal(&poller->cond);
+                pthread_mutex_unlock(&poller->lock);
+            }
+            pthread_join(poller->thread, 0);
+            poller->isStarted = 0;
+        }
+        if (poller->isInit) {
+            pthread_cond_destroy(&poller->cond);
+            pthread_mutex_destroy(&poller->lock);
+            poller->isInit = 0;
+        }
+    }
+
+    XFREE(g_cyPollers, NULL, DYNAMIC_TYPE_ASYNC);
+    g_cyPollers = NULL;
+}
+
+static int IntelQaStartPollingThreads(void)
 {
-    if (dev->qat.pollingCy == 0) {
-        dev->qat.pollingCy = 1;
+    int i;
+    IntelQaPoller* poller;
+
+    g_cyPollers = (IntelQaPoller*)XMALLOC(sizeof(IntelQaPoller) * g_numInstances,
+        NULL, DYNAMIC_TYPE_ASYNC);
+    if (g_cyPollers == NULL) {
+        printf("IntelQA: Failed to allocate pollers\n");
+        return MEMORY_E;
+    }
+    XMEMSET(g_cyPollers, 0, sizeof(IntelQaPoller) * g_numInstances);
+
+    /* setup every poller before any thread runs, submit may wake any of them */
+    for (i=0; i<g_numInstances; i++) {
+        poller = &g_cyPollers[i];
+        poller->devId = i;
+        poller->running = 1;
+        poller->respIntervalUs = QAT_POLL_SLEEP_MAX_US / 10;
+        if (pthread_mutex_init(&poller->lock, NULL) != 0) {
+            break;
+        }
+        if (pthread_cond_init(&poller->cond, NULL) != 0) {
+            pthread_mutex_destroy(&poller->lock);
+            break;
+        }
+        poller->isInit = 1;
+    }
+    if (i < g_numInstances) {
+        printf("Failed init polling thread for inst %d!\n", i);
+        IntelQaStopPollingThreads();
+        return ASYNC_INIT_E;
+    }
+
+    for (i=0; i<g_numInstances; i++) {
+        poller = &g_cyPollers[i];
+        if (pthread_create(&poller->thread, NULL, IntelQaPollingThread,
+                                                        (void*)poller) != 0) {
+            printf("Failed create polling thread for inst %d!\n", i);
+            /* stop and join the ones already started */
+            IntelQaStopPollingThreads();
+            return ASYNC_INIT_E;
+        }
+        poller->isStarted = 1;
     #ifdef QAT_DEBUG
-        printf("Polling Thread Created\n");
+        printf("Polling Thread Created: inst %d, core %u\n", i, g_cyInstMap[i]);
     #endif
-        if (pthread_create(&dev->qat.pollingThread, NULL, IntelQaPollingThread,
-                                                            (void*)dev) != 0) {
-            printf("Failed create polling thread!\n");
-            return CPA_STATUS_FAIL;
+
+    #ifndef WC_NO_ASYNC_THREADING
+        /* run on the core assigned to instance */
+        if (wc_AsyncThreadBind(&poller->thread, g_cyInstMap[i]) != 0) {
+            printf("IntelQA: Polling thread bind failed for inst %d\n", i);
         }
+    #endif
     }
-    return CPA_STATUS_SUCCESS;
+
+    return 0;
+}
+#endif /* QAT_USE_POLLING_THREAD */
+
+#ifdef WC_ASYNC_EVENTFD
+/* With polling thread the callbacks signal an eventfd for the instance.
+ * Otherwise the instance file descriptor from the driver is used, which
+ * requires the instance to be configured for epoll mode. */
+static int IntelQaEventFdInit(void)
+{
+    int i;
+
+    g_cyEventFd = (int*)XMALLOC(sizeof(int) * g_numInstances, NULL,
+        DYNAMIC_TYPE_ASYNC);
+    if (g_cyEventFd == NULL) {
+        printf("IntelQA: Failed to allocate event fds\n");
+        return MEMORY_E;
+    }
+    for (i=0; i<g_numInstances; i++) {
+        g_cyEventFd[i] = -1;
+    }
+
+#ifdef QAT_USE_POLLING_THREAD
+    g_cyEventFdSignaled = (int*)XMALLOC(sizeof(int) * g_numInstances, NULL,
+        DYNAMIC_TYPE_ASYNC);
+    if (g_cyEventFdSignaled == NULL) {
+        printf("IntelQA: Failed to allocate event fd state\n");
+        return MEMORY_E;
+    }
+    XMEMSET(g_cyEventFdSignaled, 0, sizeof(int) * g_numInstances);
+
+    for (i=0; i<g_numInstances; i++) {
+        g_cyEventFd[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (g_cyEventFd[i] < 0) {
+            printf("IntelQA: eventfd failed for inst %d! errno %d\n", i, errno);
+            return ASYNC_INIT_E;
+        }
+    }
+#endif
+
+    return 0;
+}
+
+/* must be called before instances are stopped */
+static void IntelQaEventFdFree(void)
+{
+    int i;
+
+    if (g_cyEventFd) {
+        for (i=0; i<g_numInstances; i++) {
+            if (g_cyEventFd[i] >= 0) {
+            #ifdef QAT_USE_POLLING_THREAD
+                close(g_cyEventFd[i]);
+            #else
+                icp_sal_CyPutFileDescriptor(g_cyInstances[i], g_cyEventFd[i]);
+            #endif
+                g_cyEventFd[i] = -1;
+            }
+        }
+        XFREE(g_cyEventFd, NULL, DYNAMIC_TYPE_ASYNC);
+        g_cyEventFd = NULL;
+    }
+#ifdef QAT_USE_POLLING_THREAD
+    if (g_cyEventFdSignaled) {
+        XFREE(g_cyEventFdSignaled, NULL, DYNAMIC_TYPE_ASYNC);
+        g_cyEventFdSignaled = NULL;
+    }
+#endif
 }
 
-static void IntelQaStopPollingThread(WC_ASYNC_DEV* dev)
+#ifdef QAT_USE_POLLING_THREAD
+/* wake application, only one write until application acknowledges */
+static void IntelQaEventFdSignal(int devId)
 {
-    dev->qat.pollingCy = 0;
-    pthread_join(dev->qat.pollingThread, 0);
+    word64 val = 1;
+
+    if (g_cyEventFd == NULL || g_cyEventFd[devId] < 0)
+        return;
+
+    if (__atomic_exchange_n(&g_cyEventFdSignaled[devId], 1,
+                                                    __ATOMIC_ACQ_REL) == 0) {
+        if (write(g_cyEventFd[devId], &val, sizeof(val)) != sizeof(val)) {
+            /* counter full means already readable */
+        }
+    }
 }
-#endif /* QAT_USE_POLLING_THREAD */
+#endif
+
+int IntelQaGetEventFd(int devId, int* fd)
+{
+    int ret = 0;
+
+    if (fd == NULL || devId < 0 || devId >= g_numInstances ||
+                                                        g_cyEventFd == NULL) {
+        return BAD_FUNC_ARG;
+    }
+
+#ifndef QAT_USE_POLLING_THREAD
+    if (pthread_mutex_lock(&g_Hwlock) != 0) {
+        return BAD_MUTEX_E;
+    }
+    if (g_cyEventFd[devId] < 0) {
+        CpaStatus status = icp_sal_CyGetFileDescriptor(g_cyInstances[devId],
+            &g_cyEventFd[devId]);
+        if (status != CPA_STATUS_SUCCESS) {
+            printf("icp_sal_CyGetFileDescriptor failed! inst %d, status %d "
+                   "(is instance configured for epoll?)\n", devId, status);
+            g_cyEventFd[devId] = -1;
+            ret = ASYNC_OP_E;
+        }
+    }
+    pthread_mutex_unlock(&g_Hwlock);
+#endif
+
+    *fd = g_cyEventFd[devId];
+
+    return ret;
+}
+
+/* call once fd is readable, before polling the event queue */
+int IntelQaAckEventFd(int devId)
+{
+#ifdef QAT_USE_POLLING_THREAD
+    word64 val;
+
+    if (devId < 0 || devId >= g_numInstances || g_cyEventFd == NULL) {
+        return BAD_FUNC_ARG;
+    }
+
+    /* clear counter, then allow next completion to signal */
+    if (read(g_cyEventFd[devId], &val, sizeof(val)) != sizeof(val)) {
+        /* not signaled */
+    }
+    __atomic_store_n(&g_cyEventFdSignaled[devId], 0, __ATOMIC_RELEASE);
+#else
+    /* driver fd is cleared by polling the instance */
+    (void)devId;
+#endif
+
+    return 0;
+}
+#endif /* WC_ASYNC_EVENTFD */
 
 
 
@@ -267,6 +622,13 @@ void IntelQaHardwareStop(void)
     }
 #endif
 
+#ifdef QAT_USE_POLLING_THREAD
+    IntelQaStopPollingThreads();
+#endif
+#ifdef WC_ASYNC_EVENTFD
+    IntelQaEventFdFree();
+#endif
+
     if (g_cyServiceStarted == CPA_TRUE) {
         g_cyServiceStarted = CPA_FALSE;
         for (i=0; i<g_numInstances; i++) {
@@ -295,6 +657,11 @@ void IntelQaHardwareStop(void)
         g_cyInstanceInfo = NULL;
     }
 
+    if (g_cyInstUsers) {
+        XFREE(g_cyInstUsers, NULL, DYNAMIC_TYPE_ASYNC);
+        g_cyInstUsers = NULL;
+    }
+
 #ifdef QAT_USE_POLLING_CHECK
     if (g_cyPolling) {
         XFREE(g_cyPolling, NULL, DYNAMIC_TYPE_ASYNC);
@@ -309,12 +676,22 @@ void IntelQaHardwareStop(void)
     }
 #endif
 
+#ifdef QAT_TRACK_INFLIGHT
+    if (g_cyInFlight) {
+        XFREE(g_cyInFlight, NULL, DYNAMIC_TYPE_ASYNC);
+        g_cyInFlight = NULL;
+    }
+#endif
+
     if (g_cyInstances) {
         XFREE(g_cyInstances, NULL, DYNAMIC_TYPE_ASYNC);
         g_cyInstances = NULL;
         g_numInstances = 0;
     }
 
+#ifdef USE_QAE_SLAB
+    IntelQaMemSlabFree();
+#endif
     qaeMemDestroy();
 
     printf("IntelQA: Stop\n");
@@ -384,6 +761,16 @@ int IntelQaHardwareStart(const char* process_name, int limitDevAccess)
     }
 #endif
 
+#ifdef QAT_TRACK_INFLIGHT
+    g_cyInFlight = (int*)XMALLOC(sizeof(int) * g_numInstances, NULL,
+        DYNAMIC_TYPE_ASYNC);
+    if (g_cyInFlight == NULL) {
+        printf("IntelQA: Failed to allocate in flight counters\n");
+        ret = INVALID_DEVID; goto error;
+    }
+    XMEMSET(g_cyInFlight, 0, sizeof(int) * g_numInstances);
+#endif
+
     g_cyInstanceInfo = (CpaInstanceInfo2*)XMALLOC(
         sizeof(CpaInstanceInfo2) * g_numInstances, NULL, DYNAMIC_TYPE_ASYNC);
     if (g_cyInstanceInfo == NULL) {
@@ -398,6 +785,14 @@ int IntelQaHardwareStart(const char* process_name, int limitDevAccess)
         ret = INVALID_DEVID; goto error;
     }
 
+    g_cyInstUsers = (int*)XMALLOC(sizeof(int) * g_numInstances, NULL,
+        DYNAMIC_TYPE_ASYNC);
+    if (g_cyInstUsers == NULL) {
+        printf("IntelQA: Failed to allocate instance users\n");
+        ret = INVALID_DEVID; goto error;
+    }
+    XMEMSET(g_cyInstUsers, 0, sizeof(int) * g_numInstances);
+
     status = cpaCyGetInstances(g_numInstances, g_cyInstances);
     if (status != CPA_STATUS_SUCCESS) {
         printf("IntelQA: Failed to get IntelQA instances\n");
@@ -422,7 +817,7 @@ int IntelQaHardwareStart(const char* process_name, int limitDevAccess)
         /* loop of the instanceInfo coreAffinity bitmask to find the core */
         for (j=0; j<CPA_MAX_CORES; j++) {
             if (CPA_BITMAP_BIT_TEST(g_cyInstanceInfo[i].coreAffinity, j)) {
-                coreAffinity = i;
+                coreAffinity = j;
                 break;
             }
         }
@@ -481,6 +876,19 @@ int IntelQaHardwareStart(const char* process_name, int limitDevAccess)
     *((word32*)g_qatEcdhCofactor1) = OS_HOST_TO_NW_32(1);
 #endif
 
+#ifdef WC_ASYNC_EVENTFD
+    ret = IntelQaEventFdInit();
+    if (ret != 0) {
+        goto error;
+    }
+#endif
+#ifdef QAT_USE_POLLING_THREAD
+    ret = IntelQaStartPollingThreads();
+    if (ret != 0) {
+        goto error;
+    }
+#endif
+
     printf("IntelQA: Instances %d\n", g_numInstances);
     return ret;
 
@@ -490,10 +898,52 @@ error:
 }
 
 
+/* NUMA node of the CPU the calling thread is running on, -1 if unknown */
+static int IntelQaGetNode(void)
+{
+#if !defined(QAT_NO_NUMA_AFFINITY) && defined(__linux__) && defined(SYS_getcpu)
+    unsigned int cpu = 0, node = 0;
+
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0) {
+        return (int)node;
+    }
+#endif
+    return -1;
+}
+
+/* choose instance for a new user, must hold g_Hwlock. Prefers the least used
+ * instance on the caller's node unless it has QAT_NUMA_MAX_USERS users and a
+ * remote instance has fewer. Ties are broken round robin */
+static int IntelQaSelectInstance(int node)
+{
+    int i, k, start, devId = -1, localId = -1;
+
+    start = g_instCounter % g_numInstances;
+    g_instCounter++;
+
+    for (k = 0; k < g_numInstances; k++) {
+        i = (start + k) % g_numInstances;
+        if (devId < 0 || g_cyInstUsers[i] < g_cyInstUsers[devId]) {
+            devId = i;
+        }
+        if (node >= 0 && (int)g_cyInstanceInfo[i].nodeAffinity == node &&
+            (localId < 0 || g_cyInstUsers[i] < g_cyInstUsers[localId])) {
+            localId = i;
+        }
+    }
+
+    if (localId >= 0 && (g_cyInstUsers[localId] < QAT_NUMA_MAX_USERS ||
+                         g_cyInstUsers[localId] <= g_cyInstUsers[devId])) {
+        devId = localId;
+    }
+
+    return devId;
+}
+
 int IntelQaInit(void* threadId)
 {
     int ret;
-    int devId;
+    int devId, node;
 #if !defined(WC_NO_ASYNC_THREADING) && defined(WC_ASYNC_THREAD_BIND)
     pthread_t* thread = (pthread_t*)threadId;
 #else
@@ -518,11 +968,15 @@ int IntelQaInit(void* threadId)
     }
 
     /* assign device id */
-    devId = (g_instCounter % g_numInstances);
-    g_instCounter++;
+    devId = IntelQaSelectInstance(IntelQaGetNode());
+    g_cyInstUsers[devId]++;
+    node = (int)g_cyInstanceInfo[devId].nodeAffinity;
 
     pthread_mutex_unlock(&g_Hwlock);
 
+    /* allocate this thread's buffers on the instance's node */
+    IntelQaMemSetNode(node);
+
 #if !defined(WC_NO_ASYNC_THREADING) && defined(WC_ASYNC_THREAD_BIND)
     /* if no thread provided then just return instance and don't bind */
     if (thread) {
@@ -566,13 +1020,15 @@ int IntelQaOpen(WC_ASYNC_DEV* dev, int devId)
     dev->qat.devId = devId;
     dev->qat.handle = g_cyInstances[devId];
 
-#ifdef QAT_DEBUG
-    printf("IntelQaOpen %p\n", dev);
+#if defined(QAT_ENABLE_CRYPTO) || defined(QAT_ENABLE_HASH)
+    /* buffer list is kept for the lifetime of the device */
+    if (IntelQaDevIsSym(dev) && IntelQaSymListGet(dev, 0) == NULL) {
+        return MEMORY_E;
+    }
 #endif
 
-#ifdef QAT_USE_POLLING_THREAD
-    /* start polling thread */
-    IntelQaStartPollingThread(dev);
+#ifdef QAT_DEBUG
+    printf("IntelQaOpen %p\n", dev);
 #endif
 
     return 0;
@@ -660,8 +1116,19 @@ void IntelQaClose(WC_ASYNC_DEV* dev)
 
     #if defined(QAT_ENABLE_CRYPTO) || defined(QAT_ENABLE_HASH)
         if (IntelQaDevIsSym(dev)) {
+        #ifdef QAT_ENABLE_HASH
+            if (IntelQaDevIsHash(dev)) {
+            #ifdef QAT_HASH_ENABLE_PARTIAL
+                /* wait for partials before session is removed */
+                IntelQaHashStreamFree(dev);
+            #endif
+                /* release cached input */
+                IntelQaHashChunksFree(dev);
+            }
+        #endif
             /* close any active session */
             IntelQaSymClose(dev, 1);
+            IntelQaSymListFree(dev);
         }
     #endif
     #if defined(QAT_ENABLE_RNG)
@@ -670,19 +1137,17 @@ void IntelQaClose(WC_ASYNC_DEV* dev)
         }
     #endif
 
-    #ifdef QAT_USE_POLLING_THREAD
-        IntelQaStopPollingThread(dev);
-    #endif
-
         dev->qat.handle = NULL;
     }
 }
 
 void IntelQaDeInit(int devId)
 {
-    (void)devId;
-
     if (pthread_mutex_lock(&g_Hwlock) == 0) {
+        if (g_cyInstUsers && devId >= 0 && devId < g_numInstances &&
+                g_cyInstUsers[devId] > 0) {
+            g_cyInstUsers[devId]--;
+        }
         IntelQaHardwareStop();
         pthread_mutex_unlock(&g_Hwlock);
     }
@@ -702,6 +1167,10 @@ int IntelQaDevCopy(WC_ASYNC_DEV* src, WC_ASYNC_DEV* dst)
         return BAD_FUNC_ARG;
 
 #if defined(QAT_ENABLE_HASH) || defined(QAT_ENABLE_CRYPTO)
+    /* copy gets its own buffer list on first use */
+    dst->qat.symList = NULL;
+    dst->qat.symListMax = 0;
+
     ctxDst = IntelQaGetSymCtx(dst);
     ctxSrc = IntelQaGetSymCtx(src);
 
@@ -718,25 +1187,25 @@ int IntelQaDevCopy(WC_ASYNC_DEV* src, WC_ASYNC_DEV* dst)
     /* force alloc/init on open for copy */
     ctxDst->symCtx = NULL;
     ctxDst->isOpen = 0;
-    /* if src is not open, then don't set source ctx */
-    if (!ctxSrc->isOpen)
-        ctxDst->symCtxSrc = NULL;
+    ctxDst->isCached = 0;
+    /* sessions are kept open across operations and hash state is copied
+     * explicitly, so copy owns its own session */
+    ctxDst->symCtxSrc = NULL;
 
 #ifdef QAT_ENABLE_HASH
     isHash = IntelQaDevIsHash(src);
     if (isHash) {
-        /* need to duplicate tmpIn */
-        if (src->qat.op.hash.tmpIn) {
-            dst->qat.op.hash.tmpIn = XMALLOC(src->qat.op.hash.tmpInBufSz,
-                src->heap, DYNAMIC_TYPE_ASYNC_NUMA);
-            if (dst->qat.op.hash.tmpIn == NULL) {
-                return MEMORY_E;
-            }
-            XMEMCPY(dst->qat.op.hash.tmpIn, src->qat.op.hash.tmpIn,
-                src->qat.op.hash.tmpInSz);
-            dst->qat.op.hash.tmpInSz = src->qat.op.hash.tmpInSz;
-            dst->qat.op.hash.tmpInBufSz = src->qat.op.hash.tmpInBufSz;
+        /* cached input chunks are shared, not duplicated */
+        ret = IntelQaHashChunksCopy(src, dst);
+        if (ret != 0) {
+            return ret;
+        }
+    #ifdef QAT_HASH_ENABLE_PARTIAL
+        /* streamed hash needs its own chunks and a copy of the hash state */
+        if (src->qat.op.hash.stream) {
+            ret = IntelQaHashStreamCopy(src, dst);
         }
+    #endif
     }
 #endif /* QAT_ENABLE_HASH */
 #endif /* QAT_ENABLE_HASH || QAT_ENABLE_CRYPTO */
@@ -744,36 +1213,11 @@ int IntelQaDevCopy(WC_ASYNC_DEV* src, WC_ASYNC_DEV* dst)
     return ret;
 }
 
-int IntelQaPoll(WC_ASYNC_DEV* dev)
+/* if operation is done, run cleanup and deliver result to event */
+void IntelQaOpFinish(WC_ASYNC_DEV* dev)
 {
-    int ret = 0;
-
-#ifndef QAT_USE_POLLING_THREAD
-    CpaStatus status;
     WOLF_EVENT* event = &dev->event;
 
-#ifdef QAT_USE_POLLING_CHECK
-    pthread_mutex_t* lock = &g_PollLock[dev->qat.devId];
-    if (pthread_mutex_lock(lock) == 0) {
-        /* test if any other threads are polling */
-        if (g_cyPolling[dev->qat.devId]) {
-            pthread_mutex_unlock(lock);
-
-            /* return success even though its busy, caller will treat as WC_PENDING_E */
-            return 0;
-        }
-
-        g_cyPolling[dev->qat.devId] = 1;
-        pthread_mutex_unlock(lock);
-    }
-#endif
-
-    status = icp_sal_CyPollInstance(dev->qat.handle, QAT_POLL_RESP_QUOTA);
-    if (status != CPA_STATUS_SUCCESS && status != CPA_STATUS_RETRY) {
-        printf("IntelQa: Poll failure %d\n", status);
-        ret = -1;
-    }
-
 #ifndef WC_NO_ASYNC_THREADING
     if (event->threadId == 0 || event->threadId == wc_AsyncThreadId())
 #endif
@@ -794,22 +1238,88 @@ int IntelQaPoll(WC_ASYNC_DEV* dev)
             event->ret = dev->qat.ret;
         }
     }
+}
 
-#ifdef QAT_USE_POLLING_CHECK
-    /* indicate we are done polling */
-    if (pthread_mutex_lock(lock) == 0) {
-        g_cyPolling[dev->qat.devId] = 0;
+/* poll instance once, callbacks for all devices on it are run */
+static int IntelQaPollHandle(int devId, CpaInstanceHandle handle)
+{
+    int ret = 0;
+
+#ifndef QAT_USE_POLLING_THREAD
+    CpaStatus status;
+#ifdef QAT_USE_POLLING_CHECK
+    pthread_mutex_t* lock = NULL;
+
+    if (devId >= 0 && devId < g_numInstances) {
+        lock = &g_PollLock[devId];
+    }
+    if (lock != NULL && pthread_mutex_lock(lock) == 0) {
+        /* test if any other threads are polling */
+        if (g_cyPolling[devId]) {
+            pthread_mutex_unlock(lock);
+
+            /* return success even though its busy, caller will treat as WC_PENDING_E */
+            return 0;
+        }
+
+        g_cyPolling[devId] = 1;
+        pthread_mutex_unlock(lock);
+    }
+#endif
+
+    status = icp_sal_CyPollInstance(handle, QAT_POLL_RESP_QUOTA);
+    if (status != CPA_STATUS_SUCCESS && status != CPA_STATUS_RETRY) {
+        printf("IntelQa: Poll failure %d\n", status);
+        ret = -1;
+    }
+
+#ifdef QAT_USE_POLLING_CHECK
+    /* indicate we are done polling */
+    if (lock != NULL && pthread_mutex_lock(lock) == 0) {
+        g_cyPolling[devId] = 0;
         pthread_mutex_unlock(lock);
     }
 #endif
 
 #else
-    (void)dev;
+    (void)devId;
+    (void)handle;
 #endif
 
     return ret;
 }
 
+/* poll instance by index, used when no device is at hand */
+int IntelQaPollInstance(int devId)
+{
+    CpaInstanceHandle handle = NULL;
+
+    if (devId >= 0 && devId < g_numInstances && g_cyInstances != NULL) {
+        handle = g_cyInstances[devId];
+    }
+
+    /* invalid instance fails like any other poll of a bad handle */
+    return IntelQaPollHandle(devId, handle);
+}
+
+/* poll the instance the device submitted to */
+int IntelQaPollDev(WC_ASYNC_DEV* dev)
+{
+    return IntelQaPollHandle(dev->qat.devId, dev->qat.handle);
+}
+
+int IntelQaPoll(WC_ASYNC_DEV* dev)
+{
+    int ret = 0;
+
+    /* polling thread (if used) runs callbacks */
+    ret = IntelQaPollDev(dev);
+
+    IntelQaOpFinish(dev);
+
+    return ret;
+}
+
 static int IntelQaPollBlockRet(WC_ASYNC_DEV* dev, int ret_wait)
 {
     int ret;
@@ -835,11 +1345,38 @@ int IntelQaGetCyInstanceCount(void)
     return g_numInstances;
 }
 
+#ifdef QAT_TRACK_INFLIGHT
+/* count request submitted to instance, wakes its poller when first */
+static WC_INLINE void IntelQaInFlightInc(int devId)
+{
+    if (__atomic_fetch_add(&g_cyInFlight[devId], 1, __ATOMIC_RELEASE) == 0) {
+    #ifdef QAT_USE_POLLING_THREAD
+        IntelQaPollerWake(devId);
+    #endif
+    }
+}
+#endif
+
 static WC_INLINE int IntelQaHandleCpaStatus(WC_ASYNC_DEV* dev, CpaStatus status,
     int* ret, byte isAsync, void* callback, int* retryCount)
 {
     int retry = 0;
 
+#ifdef QAT_SW_FALLBACK
+    if (status == QAT_STATUS_SW_DONE) {
+        /* already completed on CPU, finish like a hardware response */
+        status = CPA_STATUS_SUCCESS;
+    }
+    else
+#endif
+    if (status == CPA_STATUS_SUCCESS) {
+    #ifdef QAT_TRACK_INFLIGHT
+        if (callback) {
+            IntelQaInFlightInc(dev->qat.devId);
+        }
+    #endif
+    }
+
     if (status == CPA_STATUS_SUCCESS) {
         if (isAsync && callback) {
             *ret = WC_PENDING_E;
@@ -850,6 +1387,12 @@ static WC_INLINE int IntelQaHandleCpaStatus(WC_ASYNC_DEV* dev, CpaStatus status,
     }
     else if (status == CPA_STATUS_RETRY) {
         (*retryCount)++;
+    #ifdef QAT_SW_FALLBACK
+        if (*retryCount >= QAT_SW_RETRY_LIMIT) {
+            /* ring still full, next submit runs on CPU if supported */
+            dev->qat.swFallback = 1;
+        }
+    #endif
         if ((*retryCount % (QAT_RETRY_LIMIT + 1)) == QAT_RETRY_LIMIT) {
         #ifndef WC_NO_ASYNC_THREADING
             wc_AsyncThreadYield();
@@ -870,7 +1413,222 @@ static WC_INLINE void IntelQaOpInit(WC_ASYNC_DEV* dev, IntelQaFreeFunc freeFunc)
 {
     dev->qat.ret = WC_PENDING_E;
     dev->qat.freeFunc = freeFunc;
+#ifdef QAT_SW_FALLBACK
+    dev->qat.swFallback = 0;
+#endif
+}
+
+/* set result of operation, marks it complete */
+static WC_INLINE void IntelQaOpSetResult(WC_ASYNC_DEV* dev, int ret)
+{
+    /* device may be reused once result is set, so capture instance first */
+    int devId = dev->qat.devId;
+
+#ifdef WC_ASYNC_COMPLETION_RING
+    /* result must be visible before event is pushed to completion ring */
+    __atomic_store_n(&dev->qat.ret, ret, __ATOMIC_SEQ_CST);
+    wolfAsync_EventComplete(dev);
+#else
+    dev->qat.ret = ret;
+#endif
+#if defined(WC_ASYNC_EVENTFD) && defined(QAT_USE_POLLING_THREAD)
+    IntelQaEventFdSignal(devId);
+#endif
+    (void)devId;
+}
+
+/* called from callback with result of operation */
+static WC_INLINE void IntelQaOpComplete(WC_ASYNC_DEV* dev, int ret)
+{
+#ifdef QAT_TRACK_INFLIGHT
+    __atomic_sub_fetch(&g_cyInFlight[dev->qat.devId], 1, __ATOMIC_RELEASE);
+#endif
+    IntelQaOpSetResult(dev, ret);
+}
+
+/* pick instance for a stateless (PKE) operation before it is held in a batch
+ * or submitted, the instance is then fixed until the operation completes */
+static WC_INLINE void IntelQaSchedule(WC_ASYNC_DEV* dev)
+{
+#ifdef QAT_SCHED_LOAD
+    /* power of two choices: compare current instance with a random other one
+     * and move if it has fewer requests in flight */
+    static THREAD_LS_T word32 seed = 0;
+    int cur = dev->qat.devId, cand, curLoad, candLoad, diff;
+
+    if (g_numInstances <= 1 || cur < 0 || cur >= g_numInstances) {
+        return;
+    }
+
+    if (seed == 0) {
+        seed = (word32)(size_t)&seed | 1; /* unique per thread */
+    }
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    cand = (int)(seed % (word32)(g_numInstances - 1));
+    if (cand >= cur) {
+        cand++;
+    }
+
+    curLoad = __atomic_load_n(&g_cyInFlight[cur], __ATOMIC_RELAXED);
+    candLoad = __atomic_load_n(&g_cyInFlight[cand], __ATOMIC_RELAXED);
+
+    /* moving to a remote node instance must gain more */
+    diff = (g_cyInstanceInfo[cand].nodeAffinity ==
+            g_cyInstanceInfo[cur].nodeAffinity) ?
+        QAT_SCHED_MIN_DIFF : QAT_SCHED_REMOTE_DIFF;
+    if (candLoad + diff <= curLoad) {
+        dev->qat.devId = cand;
+        dev->qat.handle = g_cyInstances[cand];
+    }
+#else
+    (void)dev;
+#endif
+}
+
+#if defined(QAT_SW_FALLBACK) && !defined(NO_RSA)
+/* computes public key operation on CPU and calls its completion callback,
+ * private key operations only go to hardware and retry while it is busy */
+typedef void (*IntelQaSwFunc)(WC_ASYNC_DEV* dev);
+
+/* returns 1 if operation should run on CPU because the instance is full */
+static WC_INLINE int IntelQaSwOverflow(WC_ASYNC_DEV* dev)
+{
+    return dev->qat.swFallback ||
+        __atomic_load_n(&g_cyInFlight[dev->qat.devId], __ATOMIC_RELAXED) >=
+            QAT_SW_INFLIGHT_MAX;
+}
+
+/* run operation on CPU instead of submitting it */
+static CpaStatus IntelQaRunSw(WC_ASYNC_DEV* dev, IntelQaSwFunc swFunc)
+{
+    /* callback completes it, balance its in flight decrement */
+    __atomic_fetch_add(&g_cyInFlight[dev->qat.devId], 1, __ATOMIC_RELEASE);
+    swFunc(dev);
+
+    return QAT_STATUS_SW_DONE;
+}
+
+/* write integer big-endian, right aligned in buffer */
+static int IntelQaSwToFlatBuffer(mp_int* a, CpaFlatBuffer* buf)
+{
+    int sz = mp_unsigned_bin_size(a);
+
+    if (sz < 0 || (word32)sz > buf->dataLenInBytes) {
+        return BUFFER_E;
+    }
+    XMEMSET(buf->pData, 0, buf->dataLenInBytes - sz);
+
+    return mp_to_unsigned_bin(a, buf->pData + buf->dataLenInBytes - sz);
+}
+
+/* out = base ^ exp mod mod, exponent must be public (not constant time) */
+static int IntelQaSwExptMod(const CpaFlatBuffer* base,
+    const CpaFlatBuffer* exp, const CpaFlatBuffer* mod, CpaFlatBuffer* out)
+{
+    int ret;
+    mp_int b, e, m;
+
+    ret = mp_init_multi(&b, &e, &m, NULL, NULL, NULL);
+    if (ret != MP_OKAY) {
+        return ret;
+    }
+    ret = mp_read_unsigned_bin(&b, base->pData, base->dataLenInBytes);
+    if (ret == MP_OKAY)
+        ret = mp_read_unsigned_bin(&e, exp->pData, exp->dataLenInBytes);
+    if (ret == MP_OKAY)
+        ret = mp_read_unsigned_bin(&m, mod->pData, mod->dataLenInBytes);
+    if (ret == MP_OKAY)
+        ret = mp_exptmod(&b, &e, &m, &b);
+    if (ret == MP_OKAY)
+        ret = IntelQaSwToFlatBuffer(&b, out);
+
+    mp_clear(&b);
+    mp_clear(&e);
+    mp_clear(&m);
+
+    return ret;
+}
+#endif /* QAT_SW_FALLBACK && !NO_RSA */
+
+#ifdef WC_ASYNC_BATCH_SUBMIT
+/* hold async operation in the thread's open batch instead of submitting it,
+ * returns 1 if held */
+static int IntelQaBatchAdd(WC_ASYNC_DEV* dev, IntelQaSubmitFunc submitFunc,
+    byte isAsync)
+{
+    if (!isAsync) {
+        return 0; /* blocking operations poll for their result */
+    }
+
+    dev->qat.submitFunc = submitFunc;
+    if (wolfAsync_BatchAdd(dev) != 0) {
+        /* no batch open or batch full */
+        dev->qat.submitFunc = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+/* submit operations held by a batch back-to-back grouped by instance, sharing
+ * one retry count. Returns number submitted, failed ones are completed with
+ * the error */
+int IntelQaBatchSubmit(WC_ASYNC_DEV** devs, int count)
+{
+    int i, j, ret, devId, retryCount = 0, submitted = 0;
+    CpaStatus status;
+    WC_ASYNC_DEV* dev;
+    IntelQaSubmitFunc submitFunc;
+
+    if (devs == NULL || count < 0) {
+        return BAD_FUNC_ARG;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (devs[i] == NULL) {
+            continue;
+        }
+        devId = devs[i]->qat.devId;
+
+        for (j = i; j < count; j++) {
+            dev = devs[j];
+            if (dev == NULL || dev->qat.devId != devId) {
+                continue;
+            }
+            devs[j] = NULL;
+
+            submitFunc = dev->qat.submitFunc;
+            dev->qat.submitFunc = NULL;
+            if (submitFunc == NULL) {
+                continue;
+            }
+
+            ret = 0;
+            do {
+                status = submitFunc(dev);
+                if (status == CPA_STATUS_RETRY) {
+                    /* ring full, collect responses to free slots */
+                    IntelQaPollDev(dev);
+                }
+            } while (IntelQaHandleCpaStatus(dev, status, &ret, 1,
+                (void*)submitFunc, &retryCount));
+
+            if (ret == WC_PENDING_E) {
+                submitted++;
+            }
+            else {
+                printf("IntelQaBatchSubmit failed! dev %p, status %d, ret %d\n",
+                    dev, status, ret);
+                /* cleanup is done by IntelQaOpFinish when polled */
+                IntelQaOpSetResult(dev, ret);
+            }
+        }
+    }
+
+    return submitted;
 }
+#endif /* WC_ASYNC_BATCH_SUBMIT */
 
 
 /* -------------------------------------------------------------------------- */
@@ -942,6 +1700,10 @@ static void IntelQaGenPrimeCallback(void *pCallbackTag,
     }
 
     dev->qat.op.prime_gen.testStatus[opIndex] = testStatus;
+
+#ifdef QAT_TRACK_INFLIGHT
+    __atomic_sub_fetch(&g_cyInFlight[dev->qat.devId], 1, __ATOMIC_RELEASE);
+#endif
 }
 
 #ifndef QAT_PRIME_CHECK_TIMEOUT
@@ -1121,6 +1883,10 @@ int IntelQaGenPrime(WC_ASYNC_DEV* dev, WC_RNG* rng, byte* primeBuf,
                 errorCount++;
                 break;
             }
+        #ifdef QAT_TRACK_INFLIGHT
+            /* polling thread only polls instances with requests in flight */
+            IntelQaInFlightInc(dev->qat.devId);
+        #endif
             expectedDone++;
         }
 
@@ -1309,7 +2075,7 @@ static void IntelQaRsaKeyGenCallback(void *pCallbackTag,
     (void)opData;
 
     /* set return code to mark complete */
-    dev->qat.ret = ret;
+    IntelQaOpComplete(dev, ret);
 }
 
 int IntelQaRsaKeyGen(WC_ASYNC_DEV* dev, RsaKey* key, int keyBits, long e,
@@ -1497,7 +2263,13 @@ static void IntelQaRsaPrivateCallback(void *pCallbackTag,
     (void)opData;
 
     /* set return code to mark complete */
-    dev->qat.ret = ret;
+    IntelQaOpComplete(dev, ret);
+}
+
+static CpaStatus IntelQaRsaPrivateSubmit(WC_ASYNC_DEV* dev)
+{
+    return cpaCyRsaDecrypt(dev->qat.handle, IntelQaRsaPrivateCallback, dev,
+        &dev->qat.op.rsa_priv.opData, &dev->qat.op.rsa_priv.outBuf);
 }
 
 int IntelQaRsaPrivate(WC_ASYNC_DEV* dev,
@@ -1571,14 +2343,16 @@ int IntelQaRsaPrivate(WC_ASYNC_DEV* dev,
     dev->qat.out = out;
     dev->qat.outLenPtr = outLen;
     IntelQaOpInit(dev, IntelQaRsaPrivateFree);
+    IntelQaSchedule(dev);
 
     /* perform RSA decrypt */
+#ifdef WC_ASYNC_BATCH_SUBMIT
+    if (IntelQaBatchAdd(dev, IntelQaRsaPrivateSubmit, QAT_RSA_ASYNC)) {
+        return WC_PENDING_E; /* submitted by wolfAsync_BatchSubmit */
+    }
+#endif
     do {
-        status = cpaCyRsaDecrypt(dev->qat.handle,
-                                callback,
-                                dev,
-                                opData,
-                                outBuf);
+        status = IntelQaRsaPrivateSubmit(dev);
     } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_RSA_ASYNC, callback,
         &retryCount));
 
@@ -1672,14 +2446,16 @@ int IntelQaRsaCrtPrivate(WC_ASYNC_DEV* dev,
     dev->qat.out = out;
     dev->qat.outLenPtr = outLen;
     IntelQaOpInit(dev, IntelQaRsaPrivateFree);
+    IntelQaSchedule(dev);
 
     /* perform RSA CRT decrypt */
+#ifdef WC_ASYNC_BATCH_SUBMIT
+    if (IntelQaBatchAdd(dev, IntelQaRsaPrivateSubmit, QAT_RSA_ASYNC)) {
+        return WC_PENDING_E; /* submitted by wolfAsync_BatchSubmit */
+    }
+#endif
     do {
-        status = cpaCyRsaDecrypt(dev->qat.handle,
-                                callback,
-                                dev,
-                                opData,
-                                outBuf);
+        status = IntelQaRsaPrivateSubmit(dev);
     } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_RSA_ASYNC, callback,
         &retryCount));
 
@@ -1756,7 +2532,34 @@ static void IntelQaRsaPublicCallback(void *pCallbackTag,
     (void)opData;
 
     /* set return code to mark complete */
-    dev->qat.ret = ret;
+    IntelQaOpComplete(dev, ret);
+}
+
+#ifdef QAT_SW_FALLBACK
+static void IntelQaRsaPublicSw(WC_ASYNC_DEV* dev)
+{
+    CpaCyRsaEncryptOpData* opData = &dev->qat.op.rsa_pub.opData;
+    CpaFlatBuffer* outBuf = &dev->qat.op.rsa_pub.outBuf;
+    int ret;
+
+    ret = IntelQaSwExptMod(&opData->inputData,
+        &opData->pPublicKey->publicExponentE,
+        &opData->pPublicKey->modulusN, outBuf);
+
+    IntelQaRsaPublicCallback(dev,
+        (ret == 0) ? CPA_STATUS_SUCCESS : CPA_STATUS_FAIL, opData, outBuf);
+}
+#endif
+
+static CpaStatus IntelQaRsaPublicSubmit(WC_ASYNC_DEV* dev)
+{
+#ifdef QAT_SW_FALLBACK
+    if (IntelQaSwOverflow(dev)) {
+        return IntelQaRunSw(dev, IntelQaRsaPublicSw);
+    }
+#endif
+    return cpaCyRsaEncrypt(dev->qat.handle, IntelQaRsaPublicCallback, dev,
+        &dev->qat.op.rsa_pub.opData, &dev->qat.op.rsa_pub.outBuf);
 }
 
 int IntelQaRsaPublic(WC_ASYNC_DEV* dev,
@@ -1823,14 +2626,16 @@ int IntelQaRsaPublic(WC_ASYNC_DEV* dev,
     dev->qat.out = out;
     dev->qat.outLenPtr = outLen;
     IntelQaOpInit(dev, IntelQaRsaPublicFree);
+    IntelQaSchedule(dev);
 
     /* perform RSA encrypt */
+#ifdef WC_ASYNC_BATCH_SUBMIT
+    if (IntelQaBatchAdd(dev, IntelQaRsaPublicSubmit, QAT_RSA_ASYNC)) {
+        return WC_PENDING_E; /* submitted by wolfAsync_BatchSubmit */
+    }
+#endif
     do {
-        status = cpaCyRsaEncrypt(dev->qat.handle,
-                                callback,
-                                dev,
-                                opData,
-                                outBuf);
+        status = IntelQaRsaPublicSubmit(dev);
     } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_RSA_ASYNC, callback,
         &retryCount));
 
@@ -1905,7 +2710,13 @@ static void IntelQaRsaModExpCallback(void *pCallbackTag,
     (void)opData;
 
     /* set return code to mark complete */
-    dev->qat.ret = ret;
+    IntelQaOpComplete(dev, ret);
+}
+
+static CpaStatus IntelQaRsaModExpSubmit(WC_ASYNC_DEV* dev)
+{
+    return cpaCyLnModExp(dev->qat.handle, IntelQaRsaModExpCallback, dev,
+        &dev->qat.op.rsa_modexp.opData, &dev->qat.op.rsa_modexp.target);
 }
 
 int IntelQaRsaExptMod(WC_ASYNC_DEV* dev,
@@ -1958,14 +2769,16 @@ int IntelQaRsaExptMod(WC_ASYNC_DEV* dev,
     dev->qat.out = out;
     dev->qat.outLenPtr = outLen;
     IntelQaOpInit(dev, IntelQaRsaModExpFree);
+    IntelQaSchedule(dev);
 
     /* make modexp call async */
+#ifdef WC_ASYNC_BATCH_SUBMIT
+    if (IntelQaBatchAdd(dev, IntelQaRsaModExpSubmit, QAT_EXPTMOD_ASYNC)) {
+        return WC_PENDING_E; /* submitted by wolfAsync_BatchSubmit */
+    }
+#endif
     do {
-        status = cpaCyLnModExp(dev->qat.handle,
-                               callback,
-                               dev,
-                               opData,
-                               target);
+        status = IntelQaRsaModExpSubmit(dev);
     } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_EXPTMOD_ASYNC, callback,
         &retryCount));
 
@@ -1993,6 +2806,59 @@ exit:
 
 #if defined(QAT_ENABLE_CRYPTO) || defined(QAT_ENABLE_HASH)
 
+static void IntelQaSymListFree(WC_ASYNC_DEV* dev)
+{
+    if (dev->qat.symList) {
+        XFREE(dev->qat.symList, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+        dev->qat.symList = NULL;
+    }
+    dev->qat.symListMax = 0;
+}
+
+/* buffer list with flat buffers and driver metadata in one NUMA block. It is
+ * allocated at open and reused by each operation of the device, only growing
+ * when an operation needs more buffers. Flat buffers are returned cleared */
+static CpaBufferList* IntelQaSymListGet(WC_ASYNC_DEV* dev, word32 numBuffers)
+{
+    CpaStatus status;
+    CpaBufferList* list = dev->qat.symList;
+    Cpa32U metaSize = 0;
+    word32 maxBuffers, listSz;
+
+    if (list == NULL || numBuffers > dev->qat.symListMax) {
+        maxBuffers = (numBuffers > QAT_SYM_LIST_BUFFERS) ?
+            numBuffers : QAT_SYM_LIST_BUFFERS;
+
+        status = cpaCyBufferListGetMetaSize(dev->qat.handle, maxBuffers,
+            &metaSize);
+        if (status != CPA_STATUS_SUCCESS) {
+            return NULL;
+        }
+
+        listSz = sizeof(CpaBufferList) + (maxBuffers * sizeof(CpaFlatBuffer)) +
+            metaSize;
+        list = (CpaBufferList*)XMALLOC(listSz, dev->heap,
+            DYNAMIC_TYPE_ASYNC_NUMA);
+        if (list == NULL) {
+            return NULL;
+        }
+        XMEMSET(list, 0, listSz);
+        list->pBuffers = (CpaFlatBuffer*)((byte*)list + sizeof(CpaBufferList));
+        list->pPrivateMetaData = (byte*)list->pBuffers +
+            (maxBuffers * sizeof(CpaFlatBuffer));
+
+        IntelQaSymListFree(dev);
+        dev->qat.symList = list;
+        dev->qat.symListMax = maxBuffers;
+    }
+    else {
+        XMEMSET(list->pBuffers, 0, numBuffers * sizeof(CpaFlatBuffer));
+    }
+    list->numBuffers = numBuffers;
+
+    return list;
+}
+
 static int IntelQaSymOpen(WC_ASYNC_DEV* dev, CpaCySymSessionSetupData* setup,
     CpaCySymCbFunc callback)
 {
@@ -2062,9 +2928,6 @@ static int IntelQaSymClose(WC_ASYNC_DEV* dev, int doFree)
     int ret = 0;
     CpaStatus status = CPA_STATUS_SUCCESS;
     IntelQaSymCtx* ctx;
-#ifdef QAT_ENABLE_HASH
-    int isHash;
-#endif
 
     if (dev == NULL) {
         return BAD_FUNC_ARG;
@@ -2072,10 +2935,6 @@ static int IntelQaSymClose(WC_ASYNC_DEV* dev, int doFree)
 
     ctx = IntelQaGetSymCtx(dev);
 
-#ifdef QAT_ENABLE_HASH
-    isHash = IntelQaDevIsHash(dev);
-#endif
-
 #ifdef QAT_DEBUG
     printf("IntelQaSymClose: dev %p, ctx %p, symCtx %p (src %p), symCtxSize %d, isCopy %d, isOpen %d, doFree %d\n",
         dev, ctx, ctx->symCtx, ctx->symCtxSrc, ctx->symCtxSize, ctx->isCopy, ctx->isOpen, doFree);
@@ -2107,18 +2966,107 @@ static int IntelQaSymClose(WC_ASYNC_DEV* dev, int doFree)
         ctx->symCtxSize = 0;
     }
 
-#ifdef QAT_ENABLE_HASH
-    /* make sure hash temp buffer is cleared */
+    /* session no longer matches cached parameters */
+    ctx->isCached = 0;
+#ifndef QAT_NO_SYM_SESSION_CACHE
+    ForceZero(&ctx->session, sizeof(ctx->session));
+#endif
 
-    if (isHash) {
-        if (dev->qat.op.hash.tmpIn) {
-            XFREE(dev->qat.op.hash.tmpIn, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+    return ret;
+}
+
+#if (defined(QAT_ENABLE_CRYPTO) || defined(QAT_ENABLE_HASH)) && \
+    !defined(QAT_NO_SYM_SESSION_CACHE)
+/* returns 1 if the open session was initialized with the same setup */
+static int IntelQaSymSessionMatch(IntelQaSymCtx* ctx,
+    const CpaCySymSessionSetupData* setup)
+{
+    const IntelQaSymSession* sess = &ctx->session;
+    const CpaCySymCipherSetupData* cipher = &setup->cipherSetupData;
+    const CpaCySymHashSetupData* hash = &setup->hashSetupData;
+    word32 authKeySz = 0;
+
+    if (!ctx->isOpen || !ctx->isCached || ctx->symCtx != ctx->symCtxSrc) {
+        return 0;
+    }
+    if (sess->symOperation != setup->symOperation ||
+            sess->partialsNotRequired != setup->partialsNotRequired) {
+        return 0;
+    }
+
+    if (setup->symOperation != CPA_CY_SYM_OP_HASH) {
+        if (sess->cipherAlgorithm != cipher->cipherAlgorithm ||
+            sess->cipherDirection != cipher->cipherDirection ||
+            sess->cipherKeySz != cipher->cipherKeyLenInBytes ||
+            ConstantCompare(sess->key, cipher->pCipherKey,
+                                            cipher->cipherKeyLenInBytes) != 0) {
+            return 0;
+        }
+    }
+    if (setup->symOperation != CPA_CY_SYM_OP_CIPHER ||
+                                hash->hashAlgorithm != CPA_CY_SYM_HASH_NONE) {
+        if (hash->hashMode == CPA_CY_SYM_HASH_MODE_AUTH &&
+                                hash->authModeSetupData.authKey != NULL) {
+            authKeySz = hash->authModeSetupData.authKeyLenInBytes;
+        }
+        if (sess->hashAlgorithm != hash->hashAlgorithm ||
+            sess->hashMode != hash->hashMode ||
+            sess->digestSz != hash->digestResultLenInBytes ||
+            sess->aadSz != hash->authModeSetupData.aadLenInBytes ||
+            sess->authKeySz != authKeySz ||
+            (authKeySz > 0 && ConstantCompare(&sess->key[sess->cipherKeySz],
+                        hash->authModeSetupData.authKey, authKeySz) != 0)) {
+            return 0;
         }
     }
-#endif
 
-    return ret;
+    return 1;
+}
+
+/* remember setup of newly opened session so next operation can reuse it */
+static void IntelQaSymSessionSave(IntelQaSymCtx* ctx,
+    const CpaCySymSessionSetupData* setup)
+{
+    IntelQaSymSession* sess = &ctx->session;
+    const CpaCySymCipherSetupData* cipher = &setup->cipherSetupData;
+    const CpaCySymHashSetupData* hash = &setup->hashSetupData;
+    word32 cipherKeySz = 0, authKeySz = 0;
+
+    ctx->isCached = 0;
+
+    if (setup->symOperation != CPA_CY_SYM_OP_HASH) {
+        cipherKeySz = cipher->cipherKeyLenInBytes;
+    }
+    if (hash->hashMode == CPA_CY_SYM_HASH_MODE_AUTH &&
+                                hash->authModeSetupData.authKey != NULL) {
+        authKeySz = hash->authModeSetupData.authKeyLenInBytes;
+    }
+    if (cipherKeySz + authKeySz > QAT_SYM_SESSION_KEY_MAX) {
+        return; /* too large to cache, session will be re-initialized */
+    }
+
+    XMEMSET(sess, 0, sizeof(IntelQaSymSession));
+    sess->symOperation = setup->symOperation;
+    sess->partialsNotRequired = setup->partialsNotRequired;
+    sess->cipherAlgorithm = cipher->cipherAlgorithm;
+    sess->cipherDirection = cipher->cipherDirection;
+    sess->hashAlgorithm = hash->hashAlgorithm;
+    sess->hashMode = hash->hashMode;
+    sess->digestSz = hash->digestResultLenInBytes;
+    sess->aadSz = hash->authModeSetupData.aadLenInBytes;
+    sess->cipherKeySz = cipherKeySz;
+    sess->authKeySz = authKeySz;
+    if (cipherKeySz > 0) {
+        XMEMCPY(sess->key, cipher->pCipherKey, cipherKeySz);
+    }
+    if (authKeySz > 0) {
+        XMEMCPY(&sess->key[cipherKeySz], hash->authModeSetupData.authKey,
+            authKeySz);
+    }
+
+    ctx->isCached = 1;
 }
+#endif /* (QAT_ENABLE_CRYPTO || QAT_ENABLE_HASH) && !QAT_NO_SYM_SESSION_CACHE */
 
 #endif /* QAT_ENABLE_CRYPTO || QAT_ENABLE_HASH */
 
@@ -2128,11 +3076,117 @@ static int IntelQaSymClose(WC_ASYNC_DEV* dev, int doFree)
 /* -------------------------------------------------------------------------- */
 
 #ifdef QAT_ENABLE_CRYPTO
-static void IntelQaSymCipherFree(WC_ASYNC_DEV* dev)
+/* CCM AAD starts after the B0 block and the two byte AAD length */
+#define QAT_CCM_AAD_OFFSET (AES_BLOCK_SIZE + 2)
+
+/* copy last sz bytes of the first count buffers to out */
+static void IntelQaSgCopyTail(const CpaFlatBuffer* bufs, word32 count,
+    byte* out, word32 sz)
 {
-    IntelQaSymCtx* ctx = &dev->qat.op.cipher.ctx;
-    CpaCySymOpData* opData = &ctx->opData;
-    CpaBufferList* pDstBuffer = &dev->qat.op.cipher.bufferList;
+    word32 len;
+
+    while (sz > 0 && count > 0) {
+        count--;
+        len = bufs[count].dataLenInBytes;
+        if (len > sz)
+            len = sz;
+        sz -= len;
+        XMEMCPY(out + sz, bufs[count].pData + bufs[count].dataLenInBytes - len,
+            len);
+    }
+}
+
+static void IntelQaSymSgUnmap(WC_ASYNC_DEV* dev, CpaFlatBuffer* bufs,
+    word32 numBuffers)
+{
+    word32 i;
+
+    if (bufs == NULL) {
+        return;
+    }
+    for (i = 0; i < numBuffers; i++) {
+        if (bufs[i].pData) {
+            XFREE(bufs[i].pData, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+        }
+    }
+    XFREE(bufs, dev->heap, DYNAMIC_TYPE_ASYNC);
+}
+
+/* map fragments, then tag if set, onto flat buffers. DMA-able fragments are
+ * used in place, others are copied. The caller's pointers are kept after the
+ * QAT buffers so the callback can return data to them */
+static CpaFlatBuffer* IntelQaSymSgMap(WC_ASYNC_DEV* dev,
+    const IntelQaSgBuf* sg, word32 sgCnt, byte* authTag, word32 authTagSz,
+    word32 numBuffers)
+{
+    word32 i;
+    CpaFlatBuffer* bufs;
+    CpaFlatBuffer* orig;
+
+    bufs = (CpaFlatBuffer*)XMALLOC(sizeof(CpaFlatBuffer) * numBuffers * 2,
+        dev->heap, DYNAMIC_TYPE_ASYNC);
+    if (bufs == NULL) {
+        return NULL;
+    }
+    XMEMSET(bufs, 0, sizeof(CpaFlatBuffer) * numBuffers * 2);
+    orig = &bufs[numBuffers];
+
+    for (i = 0; i < numBuffers; i++) {
+        if (i < sgCnt) {
+            orig[i].pData = sg[i].data;
+            orig[i].dataLenInBytes = sg[i].len;
+        }
+        else {
+            orig[i].pData = authTag;
+            orig[i].dataLenInBytes = authTagSz;
+        }
+        bufs[i].pData = XREALLOC(orig[i].pData, orig[i].dataLenInBytes,
+            dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+        if (bufs[i].pData == NULL) {
+            IntelQaSymSgUnmap(dev, bufs, numBuffers);
+            return NULL;
+        }
+        bufs[i].dataLenInBytes = orig[i].dataLenInBytes;
+    }
+
+    return bufs;
+}
+
+/* return in place result to fragments that were copied */
+static void IntelQaSymCipherSgDone(WC_ASYNC_DEV* dev,
+    CpaBufferList* bufferList)
+{
+    word32 i, sgCnt = dev->qat.op.cipher.sgCount;
+    CpaFlatBuffer* bufs = bufferList->pBuffers;
+    CpaFlatBuffer* orig = &bufs[bufferList->numBuffers];
+
+    for (i = 0; i < sgCnt; i++) {
+        if (orig[i].pData != bufs[i].pData) {
+            XMEMCPY(orig[i].pData, bufs[i].pData, orig[i].dataLenInBytes);
+        }
+    }
+
+    /* capture IV for next call */
+    if (dev->qat.op.cipher.iv && dev->qat.op.cipher.ivSz > 0) {
+        IntelQaSgCopyTail(bufs, sgCnt, dev->qat.op.cipher.iv,
+            dev->qat.op.cipher.ivSz);
+    }
+
+#ifndef NO_AES
+    /* return authTag, only set for encrypt */
+    if (dev->qat.op.cipher.authTag && bufferList->numBuffers > sgCnt &&
+            orig[sgCnt].pData != bufs[sgCnt].pData) {
+        XMEMCPY(orig[sgCnt].pData, bufs[sgCnt].pData,
+            orig[sgCnt].dataLenInBytes);
+    }
+#endif
+}
+
+static void IntelQaSymCipherFree(WC_ASYNC_DEV* dev)
+{
+    IntelQaSymCtx* ctx = &dev->qat.op.cipher.ctx;
+    CpaCySymOpData* opData = &ctx->opData;
+    CpaBufferList* pDstBuffer = &dev->qat.op.cipher.bufferList;
 
     if (opData) {
         if (opData->pAdditionalAuthData) {
@@ -2146,22 +3200,28 @@ static void IntelQaSymCipherFree(WC_ASYNC_DEV* dev)
         XMEMSET(opData, 0, sizeof(CpaCySymOpData));
     }
     if (pDstBuffer) {
-        if (pDstBuffer->pBuffers) {
+        if (dev->qat.op.cipher.sgCount > 0) {
+            IntelQaSymSgUnmap(dev, pDstBuffer->pBuffers,
+                pDstBuffer->numBuffers);
+            dev->qat.op.cipher.sgCount = 0;
+        }
+        else if (pDstBuffer->pBuffers) {
             if (pDstBuffer->pBuffers->pData) {
                 XFREE(pDstBuffer->pBuffers->pData, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
                 pDstBuffer->pBuffers->pData = NULL;
             }
             XMEMSET(pDstBuffer->pBuffers, 0, sizeof(CpaFlatBuffer));
         }
-        if (pDstBuffer->pPrivateMetaData) {
-            XFREE(pDstBuffer->pPrivateMetaData, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
-            pDstBuffer->pPrivateMetaData = NULL;
-        }
+        /* metadata belongs to the device buffer list and is kept */
         XMEMSET(pDstBuffer, 0, sizeof(CpaBufferList));
     }
 
+#ifdef QAT_NO_SYM_SESSION_CACHE
     /* close and free sym context */
     IntelQaSymClose(dev, 1);
+#endif
+    /* otherwise session stays open for next operation and is removed when
+     * the key changes or in IntelQaClose */
 
     /* clear temp pointers */
     dev->qat.out = NULL;
@@ -2170,6 +3230,10 @@ static void IntelQaSymCipherFree(WC_ASYNC_DEV* dev)
     dev->qat.op.cipher.authTag = NULL;
     dev->qat.op.cipher.authTagSz = 0;
 #endif
+    dev->qat.op.cipher.hdrSz = 0;
+    dev->qat.op.cipher.padSz = 0;
+    dev->qat.op.cipher.verify = 0;
+    dev->qat.op.cipher.verifyErr = 0;
 }
 
 static void IntelQaSymCipherCallback(void *pCallbackTag, CpaStatus status,
@@ -2191,8 +3255,17 @@ static void IntelQaSymCipherCallback(void *pCallbackTag, CpaStatus status,
 #endif
 
     if (status == CPA_STATUS_SUCCESS) {
+        if (dev->qat.op.cipher.verify && verifyResult != CPA_TRUE) {
+            /* appended tag did not match, do not return data */
+            ret = dev->qat.op.cipher.verifyErr;
+        }
+        else if (dev->qat.op.cipher.sgCount > 0) {
+            /* scatter-gather is processed in place */
+            IntelQaSymCipherSgDone(dev, pDstBuffer);
+            ret = 0; /* success */
+        }
         /* validate returned output */
-        if (pDstBuffer && pDstBuffer->numBuffers >= 1) {
+        else if (pDstBuffer && pDstBuffer->numBuffers >= 1) {
             /* check length */
             word32 outLen = pDstBuffer->pBuffers->dataLenInBytes;
 
@@ -2239,15 +3312,39 @@ static void IntelQaSymCipherCallback(void *pCallbackTag, CpaStatus status,
     }
 
     /* set return code to mark complete */
-    dev->qat.ret = ret;
+    IntelQaOpComplete(dev, ret);
+}
+
+/* error for a tag that does not verify, matching the software code */
+static int IntelQaSymCipherAuthError(CpaCySymHashAlgorithm hashAlgorithm)
+{
+    switch (hashAlgorithm) {
+        case CPA_CY_SYM_HASH_AES_GCM:
+            return AES_GCM_AUTH_E;
+        case CPA_CY_SYM_HASH_AES_CCM:
+            return AES_CCM_AUTH_E;
+        default:
+            return MAC_CMP_FAILED_E;
+    }
+}
+
+static CpaStatus IntelQaSymCipherSubmit(WC_ASYNC_DEV* dev)
+{
+    CpaBufferList* bufferList = &dev->qat.op.cipher.bufferList;
+
+    /* use same buffer list for in-place operation */
+    return cpaCySymPerformOp(dev->qat.handle, dev,
+        &dev->qat.op.cipher.ctx.opData, bufferList, bufferList, NULL);
 }
 
+/* sg is used instead of in/out when set, processing fragments in place */
 static int IntelQaSymCipher(WC_ASYNC_DEV* dev, byte* out, const byte* in,
-    word32 inOutSz, const byte* key, word32 keySz, byte* iv, word32 ivSz,
+    word32 inOutSz, const IntelQaSgBuf* sg, word32 sgCnt,
+    const byte* key, word32 keySz, byte* iv, word32 ivSz,
     CpaCySymOp symOperation, CpaCySymCipherAlgorithm cipherAlgorithm,
     CpaCySymCipherDirection cipherDirection,
 
-    /* for auth ciphers (CCM or GCM) */
+    /* for auth ciphers (CCM, GCM or ChaCha20-Poly1305) */
     CpaCySymHashAlgorithm hashAlgorithm,
     byte* authTag, word32 authTagSz,
     const byte* authIn, word32 authInSz)
@@ -2256,18 +3353,19 @@ static int IntelQaSymCipher(WC_ASYNC_DEV* dev, byte* out, const byte* in,
     CpaStatus status = CPA_STATUS_SUCCESS;
     CpaCySymOpData* opData = NULL;
     CpaCySymSessionSetupData setup;
-    const Cpa32U numBuffers = 1;
+    Cpa32U numBuffers = 1;
     CpaBufferList* bufferList = NULL;
     CpaFlatBuffer* flatBuffer = NULL;
+    CpaFlatBuffer* sgBuffers = NULL;
     CpaCySymCbFunc callback = IntelQaSymCipherCallback;
     Cpa8U* ivBuf = NULL;
     Cpa8U* dataBuf = NULL;
     Cpa32U dataLen = inOutSz;
-    Cpa8U* metaBuf = NULL;
-    Cpa32U metaSize = 0;
+    CpaBufferList* metaList;
     Cpa8U* authInBuf = NULL;
     Cpa32U authInSzAligned = authInSz;
     IntelQaSymCtx* ctx;
+    word32 i;
 
 #ifdef QAT_DEBUG
     printf("IntelQaSymCipher: dev %p, out %p, in %p, inOutSz %d, op %d, algo %d, dir %d, hash %d\n",
@@ -2275,7 +3373,8 @@ static int IntelQaSymCipher(WC_ASYNC_DEV* dev, byte* out, const byte* in,
 #endif
 
     /* check args */
-    if (out == NULL || in == NULL || inOutSz == 0 ||
+    if ((sg == NULL && (out == NULL || in == NULL || inOutSz == 0)) ||
+        (sg != NULL && (sgCnt == 0 || sgCnt > QAT_SG_MAX_BUFFERS)) ||
         key == NULL || keySz == 0 || iv == NULL || ivSz == 0) {
         return BAD_FUNC_ARG;
     }
@@ -2283,15 +3382,36 @@ static int IntelQaSymCipher(WC_ASYNC_DEV* dev, byte* out, const byte* in,
         (authTag == NULL || authTagSz == 0)) {
         return BAD_FUNC_ARG;
     }
+    /* CCM nonce follows the flags byte of the counter block */
+    if (cipherAlgorithm == CPA_CY_SYM_CIPHER_AES_CCM &&
+                                                ivSz >= AES_BLOCK_SIZE) {
+        return BAD_FUNC_ARG;
+    }
+    dev->qat.op.cipher.sgCount = 0;
+
+    if (sg != NULL) {
+        /* message is the fragments, tag gets its own buffer after them */
+        inOutSz = 0;
+        for (i = 0; i < sgCnt; i++) {
+            if (sg[i].data == NULL || sg[i].len == 0) {
+                return BAD_FUNC_ARG;
+            }
+            inOutSz += sg[i].len;
+        }
+        numBuffers = sgCnt;
+        if (authTag && authTagSz > 0) {
+            numBuffers++;
+        }
+    }
 
-    /* get meta size */
-    status = cpaCyBufferListGetMetaSize(dev->qat.handle, numBuffers, &metaSize);
-    if (status != CPA_STATUS_SUCCESS && metaSize <= 0) {
-        ret = BUFFER_E; goto exit;
+    /* driver metadata is taken from the device buffer list */
+    metaList = IntelQaSymListGet(dev, numBuffers);
+    if (metaList == NULL) {
+        ret = MEMORY_E; goto exit;
     }
 
     /* if authtag provided then it will be appended to end of input */
-    if (authTag && authTagSz > 0) {
+    if (sg == NULL && authTag && authTagSz > 0) {
         dataLen += authTagSz;
     }
 
@@ -2300,17 +3420,61 @@ static int IntelQaSymCipher(WC_ASYNC_DEV* dev, byte* out, const byte* in,
     opData = &ctx->opData;
     bufferList = &dev->qat.op.cipher.bufferList;
     flatBuffer = &dev->qat.op.cipher.flatBuffer;
-    metaBuf = XMALLOC(metaSize, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
-    dataBuf = XREALLOC((byte*)in, dataLen, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
-    ivBuf = XREALLOC((byte*)iv, AES_BLOCK_SIZE, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+    if (sg == NULL) {
+        dataBuf = XREALLOC((byte*)in, dataLen, dev->heap,
+            DYNAMIC_TYPE_ASYNC_NUMA);
+    }
+    else {
+        sgBuffers = IntelQaSymSgMap(dev, sg, sgCnt, authTag, authTagSz,
+            numBuffers);
+    }
+    if (cipherAlgorithm == CPA_CY_SYM_CIPHER_AES_CCM || ivSz < AES_BLOCK_SIZE) {
+        /* short nonce is copied, CCM reserves first byte for the flags */
+        word32 ivOffset =
+            (cipherAlgorithm == CPA_CY_SYM_CIPHER_AES_CCM) ? 1 : 0;
+        ivBuf = XMALLOC(AES_BLOCK_SIZE, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+        if (ivBuf) {
+            XMEMSET(ivBuf, 0, AES_BLOCK_SIZE);
+            XMEMCPY(ivBuf + ivOffset, iv, ivSz);
+        }
+    }
+    else {
+        ivBuf = XREALLOC((byte*)iv, AES_BLOCK_SIZE, dev->heap,
+            DYNAMIC_TYPE_ASYNC_NUMA);
+    }
 
     /* check allocations */
-    if (ivBuf == NULL || metaBuf == NULL || dataBuf == NULL) {
+    if (ivBuf == NULL || (dataBuf == NULL && sgBuffers == NULL)) {
+        if (sgBuffers) {
+            IntelQaSymSgUnmap(dev, sgBuffers, numBuffers);
+        }
         ret = MEMORY_E; goto exit;
     }
 
     /* AAD */
-    if (authIn && authInSz > 0) {
+    if (cipherAlgorithm == CPA_CY_SYM_CIPHER_AES_CCM) {
+        /* B0 and AAD length go before the AAD, needed even without AAD */
+        authInSzAligned = QAT_CCM_AAD_OFFSET + authInSz;
+        if (authInSzAligned % AES_BLOCK_SIZE) {
+            authInSzAligned += AES_BLOCK_SIZE -
+                (authInSzAligned % AES_BLOCK_SIZE);
+        }
+
+        authInBuf = XMALLOC(authInSzAligned, dev->heap,
+            DYNAMIC_TYPE_ASYNC_NUMA);
+        if (authInBuf == NULL) {
+            if (sgBuffers) {
+                IntelQaSymSgUnmap(dev, sgBuffers, numBuffers);
+            }
+            ret = MEMORY_E; goto exit;
+        }
+        XMEMSET(authInBuf, 0, authInSzAligned);
+        XMEMCPY(authInBuf + 1, iv, ivSz);
+        if (authIn && authInSz > 0) {
+            XMEMCPY(authInBuf + QAT_CCM_AAD_OFFSET, authIn, authInSz);
+        }
+    }
+    else if (authIn && authInSz > 0) {
         /* make sure AAD is block aligned */
         if (authInSzAligned % AES_BLOCK_SIZE) {
             authInSzAligned += AES_BLOCK_SIZE -
@@ -2320,6 +3484,9 @@ static int IntelQaSymCipher(WC_ASYNC_DEV* dev, byte* out, const byte* in,
         authInBuf = XREALLOC((byte*)authIn, authInSzAligned, dev->heap,
             DYNAMIC_TYPE_ASYNC_NUMA);
         if (authInBuf == NULL) {
+            if (sgBuffers) {
+                IntelQaSymSgUnmap(dev, sgBuffers, numBuffers);
+            }
             ret = MEMORY_E; goto exit;
         }
         /* clear remainder */
@@ -2331,13 +3498,18 @@ static int IntelQaSymCipher(WC_ASYNC_DEV* dev, byte* out, const byte* in,
     XMEMSET(opData, 0, sizeof(CpaCySymOpData));
     XMEMSET(bufferList, 0, sizeof(CpaBufferList));
     XMEMSET(flatBuffer, 0, sizeof(CpaFlatBuffer));
-    XMEMSET(metaBuf, 0, metaSize);
 
-    bufferList->pBuffers = flatBuffer;
     bufferList->numBuffers = numBuffers;
-    bufferList->pPrivateMetaData = metaBuf;
-    flatBuffer->dataLenInBytes = dataLen;
-    flatBuffer->pData = dataBuf;
+    bufferList->pPrivateMetaData = metaList->pPrivateMetaData;
+    if (sgBuffers) {
+        bufferList->pBuffers = sgBuffers;
+        dev->qat.op.cipher.sgCount = sgCnt;
+    }
+    else {
+        bufferList->pBuffers = flatBuffer;
+        flatBuffer->dataLenInBytes = dataLen;
+        flatBuffer->pData = dataBuf;
+    }
 
     /* setup */
     setup.sessionPriority = CPA_CY_PRIORITY_NORMAL;
@@ -2349,10 +3521,13 @@ static int IntelQaSymCipher(WC_ASYNC_DEV* dev, byte* out, const byte* in,
 
     /* setup auth ciphers */
     if (hashAlgorithm != CPA_CY_SYM_HASH_NONE) {
-        setup.algChainOrder =
-            (cipherDirection == CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT) ?
-                CPA_CY_SYM_ALG_CHAIN_ORDER_CIPHER_THEN_HASH :
-                CPA_CY_SYM_ALG_CHAIN_ORDER_HASH_THEN_CIPHER;
+        /* CCM authenticates the plaintext, the others the ciphertext */
+        int hashFirst =
+            (cipherDirection == CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT) ==
+            (cipherAlgorithm == CPA_CY_SYM_CIPHER_AES_CCM);
+        setup.algChainOrder = hashFirst ?
+                CPA_CY_SYM_ALG_CHAIN_ORDER_HASH_THEN_CIPHER :
+                CPA_CY_SYM_ALG_CHAIN_ORDER_CIPHER_THEN_HASH;
 
         setup.hashSetupData.hashAlgorithm = hashAlgorithm;
         setup.hashSetupData.hashMode = CPA_CY_SYM_HASH_MODE_AUTH;
@@ -2360,13 +3535,28 @@ static int IntelQaSymCipher(WC_ASYNC_DEV* dev, byte* out, const byte* in,
         setup.hashSetupData.authModeSetupData.aadLenInBytes = authInSz;
 
         setup.digestIsAppended = CPA_TRUE;
+        if (cipherDirection == CPA_CY_SYM_CIPHER_DIRECTION_DECRYPT) {
+            setup.verifyDigest = CPA_TRUE;
+        }
+    }
+
+#ifndef QAT_NO_SYM_SESSION_CACHE
+    /* reuse open session if algorithm, direction, key and AAD are same */
+    if (ctx->isOpen && !IntelQaSymSessionMatch(ctx, &setup)) {
+        IntelQaSymClose(dev, 1);
     }
+#endif
 
     /* open session */
     ret = IntelQaSymOpen(dev, &setup, callback);
     if (ret != 0) {
         goto exit;
     }
+#ifndef QAT_NO_SYM_SESSION_CACHE
+    if (!ctx->isCached) {
+        IntelQaSymSessionSave(ctx, &setup);
+    }
+#endif
 
     /* operation data */
     opData->sessionCtx = ctx->symCtx;
@@ -2375,10 +3565,10 @@ static int IntelQaSymCipher(WC_ASYNC_DEV* dev, byte* out, const byte* in,
     opData->ivLenInBytes = ivSz;
     opData->cryptoStartSrcOffsetInBytes = 0;
     opData->messageLenToCipherInBytes = inOutSz;
-    if (authIn && authInSz > 0) {
+    if (authInBuf) {
         opData->pAdditionalAuthData = authInBuf;
     }
-    if (cipherDirection == CPA_CY_SYM_CIPHER_DIRECTION_DECRYPT) {
+    if (cipherDirection == CPA_CY_SYM_CIPHER_DIRECTION_DECRYPT && !sgBuffers) {
         if (authTag && authTagSz > 0) {
             /* append digest to end of data buffer */
             XMEMCPY(flatBuffer->pData + inOutSz, authTag, authTagSz);
@@ -2388,8 +3578,9 @@ static int IntelQaSymCipher(WC_ASYNC_DEV* dev, byte* out, const byte* in,
     /* store info needed for output */
     dev->qat.out = out;
     dev->qat.outLen = inOutSz;
-    /* optional return of next IV */
-    if (cipherAlgorithm != CPA_CY_SYM_CIPHER_AES_GCM && iv) {
+    /* optional return of next IV for CBC chaining */
+    if ((cipherAlgorithm == CPA_CY_SYM_CIPHER_AES_CBC ||
+         cipherAlgorithm == CPA_CY_SYM_CIPHER_3DES_CBC) && iv) {
         if (ivSz > inOutSz)
             ivSz = inOutSz;
         if (cipherDirection == CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT) {
@@ -2397,6 +3588,10 @@ static int IntelQaSymCipher(WC_ASYNC_DEV* dev, byte* out, const byte* in,
             dev->qat.op.cipher.iv = iv;
             dev->qat.op.cipher.ivSz = ivSz;
         }
+        else if (sgBuffers) {
+            /* capture last block of input as next IV */
+            IntelQaSgCopyTail(sgBuffers, sgCnt, iv, ivSz);
+        }
         else {
             /* capture last block of input as next IV */
             XMEMCPY(iv, &in[inOutSz - ivSz], ivSz);
@@ -2409,18 +3604,22 @@ static int IntelQaSymCipher(WC_ASYNC_DEV* dev, byte* out, const byte* in,
     else {
         dev->qat.op.cipher.authTag = NULL;
         dev->qat.op.cipher.authTagSz = 0;
+        if (hashAlgorithm != CPA_CY_SYM_HASH_NONE) {
+            dev->qat.op.cipher.verify = 1;
+            dev->qat.op.cipher.verifyErr =
+                IntelQaSymCipherAuthError(hashAlgorithm);
+        }
     }
     IntelQaOpInit(dev, IntelQaSymCipherFree);
 
     /* perform symmetric AES operation async */
-    /* use same buffer list for in-place operation */
+#ifdef WC_ASYNC_BATCH_SUBMIT
+    if (IntelQaBatchAdd(dev, IntelQaSymCipherSubmit, QAT_CIPHER_ASYNC)) {
+        return WC_PENDING_E; /* submitted by wolfAsync_BatchSubmit */
+    }
+#endif
     do {
-        status = cpaCySymPerformOp(dev->qat.handle,
-                                   dev,
-                                   opData,
-                                   bufferList,
-                                   bufferList,
-                                   NULL);
+        status = IntelQaSymCipherSubmit(dev);
     } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_CIPHER_ASYNC, callback,
         &retryCount));
 
@@ -2436,6 +3635,12 @@ exit:
 
     /* handle cleanup */
     IntelQaSymCipherFree(dev);
+#ifndef QAT_NO_SYM_SESSION_CACHE
+    if (ret != 0) {
+        /* do not reuse session after failure */
+        IntelQaSymClose(dev, 1);
+    }
+#endif
 
     return ret;
 }
@@ -2446,145 +3651,679 @@ int IntelQaSymAesCbcEncrypt(WC_ASYNC_DEV* dev,
             const byte* key, word32 keySz,
             byte* iv, word32 ivSz)
 {
-    return IntelQaSymCipher(dev, out, in, sz,
+    return IntelQaSymCipher(dev, out, in, sz, NULL, 0,
         key, keySz, iv, ivSz,
         CPA_CY_SYM_OP_CIPHER, CPA_CY_SYM_CIPHER_AES_CBC,
         CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT,
         CPA_CY_SYM_HASH_NONE, NULL, 0, NULL, 0);
 }
 
-#ifdef HAVE_AES_DECRYPT
-int IntelQaSymAesCbcDecrypt(WC_ASYNC_DEV* dev,
-            byte* out, const byte* in, word32 sz,
+int IntelQaSymAesCbcEncryptSg(WC_ASYNC_DEV* dev,
+            const IntelQaSgBuf* sg, word32 sgCnt,
             const byte* key, word32 keySz,
             byte* iv, word32 ivSz)
 {
-    return IntelQaSymCipher(dev, out, in, sz,
+    return IntelQaSymCipher(dev, NULL, NULL, 0, sg, sgCnt,
         key, keySz, iv, ivSz,
         CPA_CY_SYM_OP_CIPHER, CPA_CY_SYM_CIPHER_AES_CBC,
-        CPA_CY_SYM_CIPHER_DIRECTION_DECRYPT,
+        CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT,
         CPA_CY_SYM_HASH_NONE, NULL, 0, NULL, 0);
 }
-#endif /* HAVE_AES_DECRYPT */
-#endif /* HAVE_AES_CBC */
 
-
-#ifdef HAVE_AESGCM
-int IntelQaSymAesGcmEncrypt(WC_ASYNC_DEV* dev,
-            byte* out, const byte* in, word32 sz,
-            const byte* key, word32 keySz,
-            const byte* iv, word32 ivSz,
-            byte* authTag, word32 authTagSz,
-            const byte* authIn, word32 authInSz)
-{
-    return IntelQaSymCipher(dev, out, in, sz,
-        key, keySz, (byte*)iv, ivSz,
-        CPA_CY_SYM_OP_ALGORITHM_CHAINING, CPA_CY_SYM_CIPHER_AES_GCM,
-        CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT,
-        CPA_CY_SYM_HASH_AES_GCM, authTag, authTagSz, authIn, authInSz);
-}
 #ifdef HAVE_AES_DECRYPT
-int IntelQaSymAesGcmDecrypt(WC_ASYNC_DEV* dev,
-            byte* out, const byte* in, word32 sz,
-            const byte* key, word32 keySz,
-            const byte* iv, word32 ivSz,
-            const byte* authTag, word32 authTagSz,
-            const byte* authIn, word32 authInSz)
-{
-    return IntelQaSymCipher(dev, out, in, sz,
-        key, keySz, (byte*)iv, ivSz,
-        CPA_CY_SYM_OP_ALGORITHM_CHAINING, CPA_CY_SYM_CIPHER_AES_GCM,
-        CPA_CY_SYM_CIPHER_DIRECTION_DECRYPT,
-        CPA_CY_SYM_HASH_AES_GCM, (byte*)authTag, authTagSz, authIn, authInSz);
-}
-#endif /* HAVE_AES_DECRYPT */
-#endif /* HAVE_AESGCM */
-
-#ifndef NO_DES3
-int IntelQaSymDes3CbcEncrypt(WC_ASYNC_DEV* dev,
+int IntelQaSymAesCbcDecrypt(WC_ASYNC_DEV* dev,
             byte* out, const byte* in, word32 sz,
             const byte* key, word32 keySz,
             byte* iv, word32 ivSz)
 {
-    return IntelQaSymCipher(dev, out, in, sz,
+    return IntelQaSymCipher(dev, out, in, sz, NULL, 0,
         key, keySz, iv, ivSz,
-        CPA_CY_SYM_OP_CIPHER, CPA_CY_SYM_CIPHER_3DES_CBC,
-        CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT,
+        CPA_CY_SYM_OP_CIPHER, CPA_CY_SYM_CIPHER_AES_CBC,
+        CPA_CY_SYM_CIPHER_DIRECTION_DECRYPT,
         CPA_CY_SYM_HASH_NONE, NULL, 0, NULL, 0);
 }
 
-int IntelQaSymDes3CbcDecrypt(WC_ASYNC_DEV* dev,
-            byte* out, const byte* in, word32 sz,
+int IntelQaSymAesCbcDecryptSg(WC_ASYNC_DEV* dev,
+            const IntelQaSgBuf* sg, word32 sgCnt,
             const byte* key, word32 keySz,
             byte* iv, word32 ivSz)
 {
-    return IntelQaSymCipher(dev, out, in, sz,
+    return IntelQaSymCipher(dev, NULL, NULL, 0, sg, sgCnt,
         key, keySz, iv, ivSz,
-        CPA_CY_SYM_OP_CIPHER, CPA_CY_SYM_CIPHER_3DES_CBC,
+        CPA_CY_SYM_OP_CIPHER, CPA_CY_SYM_CIPHER_AES_CBC,
         CPA_CY_SYM_CIPHER_DIRECTION_DECRYPT,
         CPA_CY_SYM_HASH_NONE, NULL, 0, NULL, 0);
 }
-#endif /* !NO_DES3 */
+#endif /* HAVE_AES_DECRYPT */
+#endif /* HAVE_AES_CBC */
 
-#endif /* QAT_ENABLE_CRYPTO */
+#if defined(HAVE_AES_CBC) && !defined(NO_HMAC)
+/* TLS MAC-then-encrypt and decrypt-then-verify as one chained operation.
+ * The buffer holds the MAC header then the record. The hash covers the header
+ * and data, the cipher covers the record (data, MAC and padding). */
+static void IntelQaSymCbcHmacCallback(void *pCallbackTag, CpaStatus status,
+    const CpaCySymOp operationType, void *pOpData, CpaBufferList *pDstBuffer,
+    CpaBoolean verifyResult)
+{
+    WC_ASYNC_DEV* dev = (WC_ASYNC_DEV*)pCallbackTag;
+    int ret = ASYNC_OP_E;
+    byte* rec;
+    word32 recSz = dev->qat.outLen;
 
+    (void)pOpData;
+    (void)operationType;
 
-/* -------------------------------------------------------------------------- */
-/* Hashing Algo */
-/* -------------------------------------------------------------------------- */
+#ifdef QAT_DEBUG
+    printf("IntelQaSymCbcHmacCallback: dev %p, status %d, verifyResult %d\n",
+        dev, status, verifyResult);
+#endif
 
-#ifdef QAT_ENABLE_HASH
-static int IntelQaSymHashGetInfo(CpaCySymHashAlgorithm hashAlgorithm,
-    Cpa32U* pBlockSize, Cpa32U* pDigestSize)
+    if (status == CPA_STATUS_SUCCESS && pDstBuffer &&
+                                                pDstBuffer->numBuffers >= 1) {
+        rec = pDstBuffer->pBuffers->pData + dev->qat.op.cipher.hdrSz;
+
+        if (dev->qat.op.cipher.verify) {
+            /* padding is checked along with MAC, both are a bad record */
+            word32 i, padSz = dev->qat.op.cipher.padSz;
+            byte bad = (verifyResult != CPA_TRUE);
+
+            for (i = recSz - padSz; i < recSz; i++) {
+                bad |= rec[i] ^ (byte)(padSz - 1);
+            }
+            ret = bad ? MAC_CMP_FAILED_E : 0;
+        }
+        else {
+            ret = 0; /* success */
+        }
+
+        if (ret == 0) {
+            XMEMCPY(dev->qat.out, rec, recSz);
+
+            /* capture last ciphertext block as next IV */
+            if (dev->qat.op.cipher.iv && dev->qat.op.cipher.ivSz > 0) {
+                XMEMCPY(dev->qat.op.cipher.iv,
+                    &rec[recSz - dev->qat.op.cipher.ivSz],
+                    dev->qat.op.cipher.ivSz);
+            }
+        }
+    }
+
+    /* set return code to mark complete */
+    IntelQaOpComplete(dev, ret);
+}
+
+static int IntelQaSymCbcHmac(WC_ASYNC_DEV* dev, byte* out, const byte* in,
+    word32 sz, word32 dataSz, const byte* key, word32 keySz,
+    byte* iv, word32 ivSz, int macType, const byte* macKey, word32 macKeySz,
+    const byte* macHdr, word32 macHdrSz,
+    CpaCySymCipherDirection cipherDirection)
 {
-    Cpa32U blockSize = 0;
-    Cpa32U digestSize = 0;
+    int ret, retryCount = 0;
+    CpaStatus status = CPA_STATUS_SUCCESS;
+    CpaCySymOpData* opData = NULL;
+    CpaCySymSessionSetupData setup;
+    CpaBufferList* bufferList = NULL;
+    CpaFlatBuffer* flatBuffer = NULL;
+    CpaCySymCbFunc callback = IntelQaSymCbcHmacCallback;
+    word32 hashAlgorithm;
+    Cpa32U blockSize, macSz;
+    Cpa8U* ivBuf = NULL;
+    Cpa8U* dataBuf = NULL;
+    CpaBufferList* metaList;
+    IntelQaSymCtx* ctx;
+    word32 recSz, padSz;
+    int isEnc = (cipherDirection == CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT);
 
-    switch(hashAlgorithm) {
-        case CPA_CY_SYM_HASH_MD5:
-        #ifndef NO_MD5
-            blockSize = WC_MD5_BLOCK_SIZE;
-            digestSize = WC_MD5_DIGEST_SIZE;
-        #endif
-            break;
-        case CPA_CY_SYM_HASH_SHA1:
-        #ifndef NO_SHA
-            blockSize = WC_SHA_BLOCK_SIZE;
-            digestSize = WC_SHA_DIGEST_SIZE;
-        #endif
-            break;
-        case CPA_CY_SYM_HASH_SHA224:
-        #ifdef WOLFSSL_SHA224
-            blockSize = WC_SHA224_BLOCK_SIZE;
-            digestSize = WC_SHA224_DIGEST_SIZE;
-        #endif
-            break;
-        case CPA_CY_SYM_HASH_SHA256:
-        #ifndef NO_SHA256
-            blockSize = WC_SHA256_BLOCK_SIZE;
-            digestSize = WC_SHA256_DIGEST_SIZE;
-        #endif
-            break;
-        case CPA_CY_SYM_HASH_SHA384:
-        #if defined(WOLFSSL_SHA512) && defined(WOLFSSL_SHA384)
-            blockSize = WC_SHA384_BLOCK_SIZE;
-            digestSize = WC_SHA384_DIGEST_SIZE;
-        #endif
-            break;
-        case CPA_CY_SYM_HASH_SHA512:
-        #ifdef WOLFSSL_SHA512
-            blockSize = WC_SHA512_BLOCK_SIZE;
-            digestSize = WC_SHA512_DIGEST_SIZE;
-        #endif
-            break;
-    #ifdef QAT_V2
-        case CPA_CY_SYM_HASH_SHA3_256:
-        #ifdef WOLFSSL_SHA3
-            blockSize = WC_SHA3_256_BLOCK_SIZE;
-            digestSize = WC_SHA3_256_DIGEST_SIZE;
-        #endif
-            break;
-    #endif
+#ifdef QAT_DEBUG
+    printf("IntelQaSymCbcHmac: dev %p, out %p, in %p, sz %d, dataSz %d, "
+        "mac %d, dir %d\n", dev, out, in, sz, dataSz, macType, cipherDirection);
+#endif
+
+    /* check args */
+    if (out == NULL || in == NULL || key == NULL || keySz == 0 ||
+            iv == NULL || ivSz != AES_BLOCK_SIZE || macKey == NULL ||
+            macKeySz == 0 || (macHdr == NULL && macHdrSz > 0)) {
+        return BAD_FUNC_ARG;
+    }
+    ret = IntelQaHmacGetType(macType, &hashAlgorithm);
+    if (ret != 0) {
+        return ret;
+    }
+    ret = IntelQaSymHashGetInfo((CpaCySymHashAlgorithm)hashAlgorithm,
+        &blockSize, &macSz);
+    if (ret != 0 || macSz == 0) {
+        return BAD_FUNC_ARG;
+    }
+
+    /* record is data, MAC, then at least one byte of padding */
+    if (isEnc) {
+        recSz = (dataSz + macSz + AES_BLOCK_SIZE) & ~(AES_BLOCK_SIZE - 1);
+    }
+    else {
+        recSz = sz;
+        if (recSz == 0 || (recSz % AES_BLOCK_SIZE) != 0 ||
+                                                dataSz + macSz >= recSz) {
+            return BAD_FUNC_ARG;
+        }
+    }
+    padSz = recSz - dataSz - macSz;
+
+    /* driver metadata is taken from the device buffer list */
+    metaList = IntelQaSymListGet(dev, 1);
+    if (metaList == NULL) {
+        ret = MEMORY_E; goto exit;
+    }
+
+    /* allocate buffers */
+    ctx = &dev->qat.op.cipher.ctx;
+    opData = &ctx->opData;
+    bufferList = &dev->qat.op.cipher.bufferList;
+    flatBuffer = &dev->qat.op.cipher.flatBuffer;
+    dev->qat.op.cipher.sgCount = 0;
+    dataBuf = XMALLOC(macHdrSz + recSz, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+    ivBuf = XREALLOC((byte*)iv, AES_BLOCK_SIZE, dev->heap,
+        DYNAMIC_TYPE_ASYNC_NUMA);
+
+    /* init buffers */
+    XMEMSET(&setup, 0, sizeof(CpaCySymSessionSetupData));
+    XMEMSET(opData, 0, sizeof(CpaCySymOpData));
+    XMEMSET(bufferList, 0, sizeof(CpaBufferList));
+    XMEMSET(flatBuffer, 0, sizeof(CpaFlatBuffer));
+    bufferList->numBuffers = 1;
+    bufferList->pBuffers = flatBuffer;
+    bufferList->pPrivateMetaData = metaList->pPrivateMetaData;
+    flatBuffer->dataLenInBytes = macHdrSz + recSz;
+    flatBuffer->pData = dataBuf;
+    opData->pIv = ivBuf;
+
+    /* check allocations */
+    if (ivBuf == NULL || dataBuf == NULL) {
+        ret = MEMORY_E; goto exit;
+    }
+
+    if (macHdrSz > 0) {
+        XMEMCPY(dataBuf, macHdr, macHdrSz);
+    }
+    if (isEnc) {
+        XMEMCPY(dataBuf + macHdrSz, in, dataSz);
+        /* MAC is written after data, TLS padding goes after it */
+        XMEMSET(dataBuf + macHdrSz + dataSz + macSz, (byte)(padSz - 1), padSz);
+    }
+    else {
+        XMEMCPY(dataBuf + macHdrSz, in, recSz);
+    }
+
+    /* setup */
+    setup.sessionPriority = CPA_CY_PRIORITY_NORMAL;
+    setup.symOperation = CPA_CY_SYM_OP_ALGORITHM_CHAINING;
+    setup.algChainOrder = isEnc ? CPA_CY_SYM_ALG_CHAIN_ORDER_HASH_THEN_CIPHER :
+                                  CPA_CY_SYM_ALG_CHAIN_ORDER_CIPHER_THEN_HASH;
+    setup.cipherSetupData.cipherAlgorithm = CPA_CY_SYM_CIPHER_AES_CBC;
+    setup.cipherSetupData.cipherKeyLenInBytes = keySz;
+    setup.cipherSetupData.pCipherKey = (byte*)key;
+    setup.cipherSetupData.cipherDirection = cipherDirection;
+    setup.hashSetupData.hashAlgorithm = (CpaCySymHashAlgorithm)hashAlgorithm;
+    setup.hashSetupData.hashMode = CPA_CY_SYM_HASH_MODE_AUTH;
+    setup.hashSetupData.digestResultLenInBytes = macSz;
+    setup.hashSetupData.authModeSetupData.authKey = (byte*)macKey;
+    setup.hashSetupData.authModeSetupData.authKeyLenInBytes = macKeySz;
+    setup.digestIsAppended = CPA_TRUE;
+    setup.verifyDigest = isEnc ? CPA_FALSE : CPA_TRUE;
+
+#ifndef QAT_NO_SYM_SESSION_CACHE
+    /* reuse open session if direction and keys are same */
+    if (ctx->isOpen && !IntelQaSymSessionMatch(ctx, &setup)) {
+        IntelQaSymClose(dev, 1);
+    }
+#endif
+
+    /* open session */
+    ret = IntelQaSymOpen(dev, &setup, callback);
+    if (ret != 0) {
+        goto exit;
+    }
+#ifndef QAT_NO_SYM_SESSION_CACHE
+    if (!ctx->isCached) {
+        IntelQaSymSessionSave(ctx, &setup);
+    }
+#endif
+
+    /* operation data */
+    opData->sessionCtx = ctx->symCtx;
+    opData->packetType = CPA_CY_SYM_PACKET_TYPE_FULL;
+    opData->ivLenInBytes = ivSz;
+    opData->cryptoStartSrcOffsetInBytes = macHdrSz;
+    opData->messageLenToCipherInBytes = recSz;
+    opData->hashStartSrcOffsetInBytes = 0;
+    opData->messageLenToHashInBytes = macHdrSz + dataSz;
+
+    /* store info needed for output */
+    dev->qat.out = out;
+    dev->qat.outLen = recSz;
+    dev->qat.op.cipher.hdrSz = macHdrSz;
+    dev->qat.op.cipher.padSz = padSz;
+    dev->qat.op.cipher.verify = !isEnc;
+    if (isEnc) {
+        /* capture this on the callback */
+        dev->qat.op.cipher.iv = iv;
+        dev->qat.op.cipher.ivSz = ivSz;
+    }
+    else {
+        /* capture last block of input as next IV */
+        XMEMCPY(iv, &in[recSz - ivSz], ivSz);
+        dev->qat.op.cipher.iv = NULL;
+        dev->qat.op.cipher.ivSz = 0;
+    }
+    dev->qat.op.cipher.authTag = NULL;
+    dev->qat.op.cipher.authTagSz = 0;
+    IntelQaOpInit(dev, IntelQaSymCipherFree);
+
+    /* perform chained hash and cipher operation async */
+    /* use same buffer list for in-place operation */
+    do {
+        status = cpaCySymPerformOp(dev->qat.handle,
+                                   dev,
+                                   opData,
+                                   bufferList,
+                                   bufferList,
+                                   NULL);
+    } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_CIPHER_ASYNC, callback,
+        &retryCount));
+
+    if (ret == WC_PENDING_E)
+        return ret;
+
+exit:
+
+    if (ret != 0) {
+        printf("cpaCySymPerformOp Cipher HMAC failed! dev %p, status %d, ret %d\n",
+            dev, status, ret);
+    }
+
+    /* handle cleanup */
+    IntelQaSymCipherFree(dev);
+#ifndef QAT_NO_SYM_SESSION_CACHE
+    if (ret != 0 && ret != MAC_CMP_FAILED_E) {
+        /* do not reuse session after failure */
+        IntelQaSymClose(dev, 1);
+    }
+#endif
+
+    return ret;
+}
+
+int IntelQaSymAesCbcHmacEncrypt(WC_ASYNC_DEV* dev,
+            byte* out, word32* outSz, const byte* in, word32 sz,
+            const byte* key, word32 keySz, byte* iv, word32 ivSz,
+            int macType, const byte* macKey, word32 macKeySz,
+            const byte* macHdr, word32 macHdrSz)
+{
+    word32 hashAlgorithm;
+    Cpa32U macSz = 0;
+    word32 recSz;
+
+    if (outSz == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (IntelQaHmacGetType(macType, &hashAlgorithm) != 0 ||
+            IntelQaSymHashGetInfo((CpaCySymHashAlgorithm)hashAlgorithm, NULL,
+                &macSz) != 0) {
+        return BAD_FUNC_ARG;
+    }
+    recSz = (sz + macSz + AES_BLOCK_SIZE) & ~(AES_BLOCK_SIZE - 1);
+    if (*outSz < recSz) {
+        return BUFFER_E;
+    }
+    *outSz = recSz;
+
+    return IntelQaSymCbcHmac(dev, out, in, 0, sz, key, keySz, iv, ivSz,
+        macType, macKey, macKeySz, macHdr, macHdrSz,
+        CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT);
+}
+
+#ifdef HAVE_AES_DECRYPT
+int IntelQaSymAesCbcHmacDecrypt(WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz, word32 dataSz,
+            const byte* key, word32 keySz, byte* iv, word32 ivSz,
+            int macType, const byte* macKey, word32 macKeySz,
+            const byte* macHdr, word32 macHdrSz)
+{
+    return IntelQaSymCbcHmac(dev, out, in, sz, dataSz, key, keySz, iv, ivSz,
+        macType, macKey, macKeySz, macHdr, macHdrSz,
+        CPA_CY_SYM_CIPHER_DIRECTION_DECRYPT);
+}
+#endif /* HAVE_AES_DECRYPT */
+#endif /* HAVE_AES_CBC && !NO_HMAC */
+
+
+#ifdef HAVE_AESGCM
+int IntelQaSymAesGcmEncrypt(WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz,
+            const byte* key, word32 keySz,
+            const byte* iv, word32 ivSz,
+            byte* authTag, word32 authTagSz,
+            const byte* authIn, word32 authInSz)
+{
+    return IntelQaSymCipher(dev, out, in, sz, NULL, 0,
+        key, keySz, (byte*)iv, ivSz,
+        CPA_CY_SYM_OP_ALGORITHM_CHAINING, CPA_CY_SYM_CIPHER_AES_GCM,
+        CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT,
+        CPA_CY_SYM_HASH_AES_GCM, authTag, authTagSz, authIn, authInSz);
+}
+
+int IntelQaSymAesGcmEncryptSg(WC_ASYNC_DEV* dev,
+            const IntelQaSgBuf* sg, word32 sgCnt,
+            const byte* key, word32 keySz,
+            const byte* iv, word32 ivSz,
+            byte* authTag, word32 authTagSz,
+            const byte* authIn, word32 authInSz)
+{
+    return IntelQaSymCipher(dev, NULL, NULL, 0, sg, sgCnt,
+        key, keySz, (byte*)iv, ivSz,
+        CPA_CY_SYM_OP_ALGORITHM_CHAINING, CPA_CY_SYM_CIPHER_AES_GCM,
+        CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT,
+        CPA_CY_SYM_HASH_AES_GCM, authTag, authTagSz, authIn, authInSz);
+}
+#ifdef HAVE_AES_DECRYPT
+int IntelQaSymAesGcmDecrypt(WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz,
+            const byte* key, word32 keySz,
+            const byte* iv, word32 ivSz,
+            const byte* authTag, word32 authTagSz,
+            const byte* authIn, word32 authInSz)
+{
+    return IntelQaSymCipher(dev, out, in, sz, NULL, 0,
+        key, keySz, (byte*)iv, ivSz,
+        CPA_CY_SYM_OP_ALGORITHM_CHAINING, CPA_CY_SYM_CIPHER_AES_GCM,
+        CPA_CY_SYM_CIPHER_DIRECTION_DECRYPT,
+        CPA_CY_SYM_HASH_AES_GCM, (byte*)authTag, authTagSz, authIn, authInSz);
+}
+
+int IntelQaSymAesGcmDecryptSg(WC_ASYNC_DEV* dev,
+            const IntelQaSgBuf* sg, word32 sgCnt,
+            const byte* key, word32 keySz,
+            const byte* iv, word32 ivSz,
+            const byte* authTag, word32 authTagSz,
+            const byte* authIn, word32 authInSz)
+{
+    return IntelQaSymCipher(dev, NULL, NULL, 0, sg, sgCnt,
+        key, keySz, (byte*)iv, ivSz,
+        CPA_CY_SYM_OP_ALGORITHM_CHAINING, CPA_CY_SYM_CIPHER_AES_GCM,
+        CPA_CY_SYM_CIPHER_DIRECTION_DECRYPT,
+        CPA_CY_SYM_HASH_AES_GCM, (byte*)authTag, authTagSz, authIn, authInSz);
+}
+#endif /* HAVE_AES_DECRYPT */
+
+#ifdef WC_ASYNC_BATCH_SUBMIT
+/* prepare records in batches, submit each batch back-to-back and then wait
+ * for all of them, a poll collects responses for the whole group */
+static int IntelQaSymAesGcmBurst(IntelQaGcmReq* reqs, word32 count, int enc)
+{
+    int ret = 0, submitted;
+    word32 i, j, n;
+    WC_ASYNC_BATCH batch;
+    IntelQaGcmReq* req;
+
+    if (reqs == NULL) {
+        return BAD_FUNC_ARG;
+    }
+
+    for (i = 0; i < count; i += n) {
+        n = count - i;
+        if (n > WC_ASYNC_BATCH_MAX)
+            n = WC_ASYNC_BATCH_MAX;
+
+        ret = wolfAsync_BatchBegin(&batch);
+        if (ret != 0) {
+            break; /* batch already open on this thread */
+        }
+        for (j = i; j < i + n; j++) {
+            req = &reqs[j];
+            if (req->dev == NULL) {
+                req->ret = BAD_FUNC_ARG;
+            }
+            else if (enc) {
+                req->ret = IntelQaSymAesGcmEncrypt(req->dev, req->out,
+                    req->in, req->sz, req->key, req->keySz, req->iv,
+                    req->ivSz, req->authTag, req->authTagSz, req->authIn,
+                    req->authInSz);
+            }
+        #ifdef HAVE_AES_DECRYPT
+            else {
+                req->ret = IntelQaSymAesGcmDecrypt(req->dev, req->out,
+                    req->in, req->sz, req->key, req->keySz, req->iv,
+                    req->ivSz, req->authTag, req->authTagSz, req->authIn,
+                    req->authInSz);
+            }
+        #else
+            else {
+                req->ret = NOT_COMPILED_IN;
+            }
+        #endif
+        }
+        submitted = wolfAsync_BatchSubmit(&batch);
+
+        /* records still held were never submitted and would never complete,
+         * fail them so the harvest below does not wait on them */
+        for (j = i; j < i + n; j++) {
+            req = &reqs[j];
+            if (req->ret == WC_PENDING_E && req->dev->qat.submitFunc != NULL) {
+                req->dev->qat.submitFunc = NULL;
+                IntelQaOpSetResult(req->dev,
+                    (submitted < 0) ? submitted : ASYNC_OP_E);
+                IntelQaOpFinish(req->dev);
+                req->ret = req->dev->qat.ret;
+            }
+        }
+    }
+
+    /* harvest submitted records, including those before a failure */
+    for (j = 0; j < i; j++) {
+        req = &reqs[j];
+        if (req->ret == WC_PENDING_E) {
+            req->ret = IntelQaPollBlockRet(req->dev, WC_PENDING_E);
+        }
+        if (req->ret != 0 && ret == 0) {
+            ret = req->ret;
+        }
+    }
+
+    return ret;
+}
+
+int IntelQaSymAesGcmEncryptBurst(IntelQaGcmReq* reqs, word32 count)
+{
+    return IntelQaSymAesGcmBurst(reqs, count, 1);
+}
+#ifdef HAVE_AES_DECRYPT
+int IntelQaSymAesGcmDecryptBurst(IntelQaGcmReq* reqs, word32 count)
+{
+    return IntelQaSymAesGcmBurst(reqs, count, 0);
+}
+#endif /* HAVE_AES_DECRYPT */
+#endif /* WC_ASYNC_BATCH_SUBMIT */
+#endif /* HAVE_AESGCM */
+
+#ifdef HAVE_AESCCM
+int IntelQaSymAesCcmEncrypt(WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz,
+            const byte* key, word32 keySz,
+            const byte* nonce, word32 nonceSz,
+            byte* authTag, word32 authTagSz,
+            const byte* authIn, word32 authInSz)
+{
+    return IntelQaSymCipher(dev, out, in, sz, NULL, 0,
+        key, keySz, (byte*)nonce, nonceSz,
+        CPA_CY_SYM_OP_ALGORITHM_CHAINING, CPA_CY_SYM_CIPHER_AES_CCM,
+        CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT,
+        CPA_CY_SYM_HASH_AES_CCM, authTag, authTagSz, authIn, authInSz);
+}
+#ifdef HAVE_AES_DECRYPT
+int IntelQaSymAesCcmDecrypt(WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz,
+            const byte* key, word32 keySz,
+            const byte* nonce, word32 nonceSz,
+            const byte* authTag, word32 authTagSz,
+            const byte* authIn, word32 authInSz)
+{
+    return IntelQaSymCipher(dev, out, in, sz, NULL, 0,
+        key, keySz, (byte*)nonce, nonceSz,
+        CPA_CY_SYM_OP_ALGORITHM_CHAINING, CPA_CY_SYM_CIPHER_AES_CCM,
+        CPA_CY_SYM_CIPHER_DIRECTION_DECRYPT,
+        CPA_CY_SYM_HASH_AES_CCM, (byte*)authTag, authTagSz, authIn, authInSz);
+}
+#endif /* HAVE_AES_DECRYPT */
+#endif /* HAVE_AESCCM */
+
+#ifdef WOLFSSL_AES_XTS
+int IntelQaSymAesXtsEncrypt(WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz,
+            const byte* key, word32 keySz,
+            const byte* iv, word32 ivSz)
+{
+    /* no ciphertext stealing on the device */
+    if (sz % AES_BLOCK_SIZE) {
+        return BAD_FUNC_ARG;
+    }
+    return IntelQaSymCipher(dev, out, in, sz, NULL, 0,
+        key, keySz, (byte*)iv, ivSz,
+        CPA_CY_SYM_OP_CIPHER, CPA_CY_SYM_CIPHER_AES_XTS,
+        CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT,
+        CPA_CY_SYM_HASH_NONE, NULL, 0, NULL, 0);
+}
+#ifdef HAVE_AES_DECRYPT
+int IntelQaSymAesXtsDecrypt(WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz,
+            const byte* key, word32 keySz,
+            const byte* iv, word32 ivSz)
+{
+    if (sz % AES_BLOCK_SIZE) {
+        return BAD_FUNC_ARG;
+    }
+    return IntelQaSymCipher(dev, out, in, sz, NULL, 0,
+        key, keySz, (byte*)iv, ivSz,
+        CPA_CY_SYM_OP_CIPHER, CPA_CY_SYM_CIPHER_AES_XTS,
+        CPA_CY_SYM_CIPHER_DIRECTION_DECRYPT,
+        CPA_CY_SYM_HASH_NONE, NULL, 0, NULL, 0);
+}
+#endif /* HAVE_AES_DECRYPT */
+#endif /* WOLFSSL_AES_XTS */
+
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305) && defined(QAT_V2_4_PLUS)
+int IntelQaSymChaCha20Poly1305Encrypt(WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz,
+            const byte* key, word32 keySz,
+            const byte* iv, word32 ivSz,
+            byte* authTag, word32 authTagSz,
+            const byte* authIn, word32 authInSz)
+{
+    return IntelQaSymCipher(dev, out, in, sz, NULL, 0,
+        key, keySz, (byte*)iv, ivSz,
+        CPA_CY_SYM_OP_ALGORITHM_CHAINING, CPA_CY_SYM_CIPHER_CHACHA,
+        CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT,
+        CPA_CY_SYM_HASH_POLY, authTag, authTagSz, authIn, authInSz);
+}
+
+int IntelQaSymChaCha20Poly1305Decrypt(WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz,
+            const byte* key, word32 keySz,
+            const byte* iv, word32 ivSz,
+            const byte* authTag, word32 authTagSz,
+            const byte* authIn, word32 authInSz)
+{
+    return IntelQaSymCipher(dev, out, in, sz, NULL, 0,
+        key, keySz, (byte*)iv, ivSz,
+        CPA_CY_SYM_OP_ALGORITHM_CHAINING, CPA_CY_SYM_CIPHER_CHACHA,
+        CPA_CY_SYM_CIPHER_DIRECTION_DECRYPT,
+        CPA_CY_SYM_HASH_POLY, (byte*)authTag, authTagSz, authIn, authInSz);
+}
+#endif /* HAVE_CHACHA && HAVE_POLY1305 && QAT_V2_4_PLUS */
+
+#ifndef NO_DES3
+int IntelQaSymDes3CbcEncrypt(WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz,
+            const byte* key, word32 keySz,
+            byte* iv, word32 ivSz)
+{
+    return IntelQaSymCipher(dev, out, in, sz, NULL, 0,
+        key, keySz, iv, ivSz,
+        CPA_CY_SYM_OP_CIPHER, CPA_CY_SYM_CIPHER_3DES_CBC,
+        CPA_CY_SYM_CIPHER_DIRECTION_ENCRYPT,
+        CPA_CY_SYM_HASH_NONE, NULL, 0, NULL, 0);
+}
+
+int IntelQaSymDes3CbcDecrypt(WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz,
+            const byte* key, word32 keySz,
+            byte* iv, word32 ivSz)
+{
+    return IntelQaSymCipher(dev, out, in, sz, NULL, 0,
+        key, keySz, iv, ivSz,
+        CPA_CY_SYM_OP_CIPHER, CPA_CY_SYM_CIPHER_3DES_CBC,
+        CPA_CY_SYM_CIPHER_DIRECTION_DECRYPT,
+        CPA_CY_SYM_HASH_NONE, NULL, 0, NULL, 0);
+}
+#endif /* !NO_DES3 */
+
+#endif /* QAT_ENABLE_CRYPTO */
+
+
+/* -------------------------------------------------------------------------- */
+/* Hashing Algo */
+/* -------------------------------------------------------------------------- */
+
+#ifdef QAT_ENABLE_HASH
+static int IntelQaSymHashGetInfo(CpaCySymHashAlgorithm hashAlgorithm,
+    Cpa32U* pBlockSize, Cpa32U* pDigestSize)
+{
+    Cpa32U blockSize = 0;
+    Cpa32U digestSize = 0;
+
+    switch(hashAlgorithm) {
+        case CPA_CY_SYM_HASH_MD5:
+        #ifndef NO_MD5
+            blockSize = WC_MD5_BLOCK_SIZE;
+            digestSize = WC_MD5_DIGEST_SIZE;
+        #endif
+            break;
+        case CPA_CY_SYM_HASH_SHA1:
+        #ifndef NO_SHA
+            blockSize = WC_SHA_BLOCK_SIZE;
+            digestSize = WC_SHA_DIGEST_SIZE;
+        #endif
+            break;
+        case CPA_CY_SYM_HASH_SHA224:
+        #ifdef WOLFSSL_SHA224
+            blockSize = WC_SHA224_BLOCK_SIZE;
+            digestSize = WC_SHA224_DIGEST_SIZE;
+        #endif
+            break;
+        case CPA_CY_SYM_HASH_SHA256:
+        #ifndef NO_SHA256
+            blockSize = WC_SHA256_BLOCK_SIZE;
+            digestSize = WC_SHA256_DIGEST_SIZE;
+        #endif
+            break;
+        case CPA_CY_SYM_HASH_SHA384:
+        #if defined(WOLFSSL_SHA512) && defined(WOLFSSL_SHA384)
+            blockSize = WC_SHA384_BLOCK_SIZE;
+            digestSize = WC_SHA384_DIGEST_SIZE;
+        #endif
+            break;
+        case CPA_CY_SYM_HASH_SHA512:
+        #ifdef WOLFSSL_SHA512
+            blockSize = WC_SHA512_BLOCK_SIZE;
+            digestSize = WC_SHA512_DIGEST_SIZE;
+        #endif
+            break;
+    #ifdef QAT_V2
+        case CPA_CY_SYM_HASH_SHA3_256:
+        #ifdef WOLFSSL_SHA3
+            blockSize = WC_SHA3_256_BLOCK_SIZE;
+            digestSize = WC_SHA3_256_DIGEST_SIZE;
+        #endif
+            break;
+    #endif
 
         /* not supported */
         case CPA_CY_SYM_HASH_NONE:
@@ -2620,6 +4359,143 @@ static int IntelQaSymHashGetInfo(CpaCySymHashAlgorithm hashAlgorithm,
     return 0;
 }
 
+/* Hash updates are cached in fixed size NUMA chunks, which are passed to
+ * hardware as a multi-buffer list on final. Appending never moves prior
+ * input. Copies share the chunks: only full chunks are ever followed by
+ * another, so the last chunk is the only one written and it is copied first
+ * if shared. */
+#ifndef QAT_HASH_CHUNK_SZ
+    #define QAT_HASH_CHUNK_SZ 4096 /* includes chunk header */
+#endif
+
+typedef struct IntelQaHashChunk {
+    int refCnt; /* hashes using this chunk */
+    int pad;    /* keeps data 8 byte aligned */
+} IntelQaHashChunk;
+
+#define QAT_HASH_CHUNK_DATA(c) ((byte*)(c) + sizeof(IntelQaHashChunk))
+#define QAT_HASH_CHUNK_CAP     (QAT_HASH_CHUNK_SZ - sizeof(IntelQaHashChunk))
+
+static void IntelQaHashChunkRelease(WC_ASYNC_DEV* dev, IntelQaHashChunk* chunk)
+{
+    if (__atomic_sub_fetch(&chunk->refCnt, 1, __ATOMIC_ACQ_REL) == 0) {
+        XFREE(chunk, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+    }
+}
+
+static void IntelQaHashChunksFree(WC_ASYNC_DEV* dev)
+{
+    word32 i;
+
+    if (dev->qat.op.hash.chunks) {
+        for (i = 0; i < dev->qat.op.hash.chunkCnt; i++) {
+            IntelQaHashChunkRelease(dev, dev->qat.op.hash.chunks[i]);
+        }
+        XFREE(dev->qat.op.hash.chunks, dev->heap, DYNAMIC_TYPE_ASYNC);
+    }
+    dev->qat.op.hash.chunks = NULL;
+    dev->qat.op.hash.chunkCnt = 0;
+    dev->qat.op.hash.chunkMax = 0;
+    dev->qat.op.hash.inSz = 0;
+}
+
+static int IntelQaHashChunksCopy(WC_ASYNC_DEV* src, WC_ASYNC_DEV* dst)
+{
+    word32 i, cnt = src->qat.op.hash.chunkCnt;
+
+    dst->qat.op.hash.chunks = NULL;
+    dst->qat.op.hash.chunkCnt = 0;
+    dst->qat.op.hash.chunkMax = 0;
+    dst->qat.op.hash.inSz = 0;
+    if (cnt == 0) {
+        return 0;
+    }
+
+    dst->qat.op.hash.chunks = (IntelQaHashChunk**)XMALLOC(
+        src->qat.op.hash.chunkMax * sizeof(IntelQaHashChunk*), dst->heap,
+        DYNAMIC_TYPE_ASYNC);
+    if (dst->qat.op.hash.chunks == NULL) {
+        return MEMORY_E;
+    }
+    for (i = 0; i < cnt; i++) {
+        dst->qat.op.hash.chunks[i] = src->qat.op.hash.chunks[i];
+        __atomic_add_fetch(&dst->qat.op.hash.chunks[i]->refCnt, 1,
+            __ATOMIC_RELAXED);
+    }
+    dst->qat.op.hash.chunkCnt = cnt;
+    dst->qat.op.hash.chunkMax = src->qat.op.hash.chunkMax;
+    dst->qat.op.hash.inSz = src->qat.op.hash.inSz;
+
+    return 0;
+}
+
+static int IntelQaHashChunksAdd(WC_ASYNC_DEV* dev, const byte* in, word32 sz)
+{
+    IntelQaHashChunk* chunk;
+    IntelQaHashChunk** chunks;
+    word32 used, len;
+
+    while (sz > 0) {
+        used = dev->qat.op.hash.inSz % QAT_HASH_CHUNK_CAP;
+
+        if (used == 0) {
+            /* no chunk yet or last one is full */
+            if (dev->qat.op.hash.chunkCnt == dev->qat.op.hash.chunkMax) {
+                len = (dev->qat.op.hash.chunkMax > 0) ?
+                    dev->qat.op.hash.chunkMax * 2 : 4;
+                chunks = (IntelQaHashChunk**)XMALLOC(
+                    len * sizeof(IntelQaHashChunk*), dev->heap,
+                    DYNAMIC_TYPE_ASYNC);
+                if (chunks == NULL) {
+                    return MEMORY_E;
+                }
+                if (dev->qat.op.hash.chunks) {
+                    XMEMCPY(chunks, dev->qat.op.hash.chunks,
+                        dev->qat.op.hash.chunkCnt * sizeof(IntelQaHashChunk*));
+                    XFREE(dev->qat.op.hash.chunks, dev->heap,
+                        DYNAMIC_TYPE_ASYNC);
+                }
+                dev->qat.op.hash.chunks = chunks;
+                dev->qat.op.hash.chunkMax = len;
+            }
+            chunk = (IntelQaHashChunk*)XMALLOC(QAT_HASH_CHUNK_SZ, dev->heap,
+                DYNAMIC_TYPE_ASYNC_NUMA);
+            if (chunk == NULL) {
+                return MEMORY_E;
+            }
+            chunk->refCnt = 1;
+            dev->qat.op.hash.chunks[dev->qat.op.hash.chunkCnt++] = chunk;
+        }
+        else {
+            chunk = dev->qat.op.hash.chunks[dev->qat.op.hash.chunkCnt - 1];
+            if (__atomic_load_n(&chunk->refCnt, __ATOMIC_ACQUIRE) > 1) {
+                /* copy on write of shared last chunk */
+                IntelQaHashChunk* own = (IntelQaHashChunk*)XMALLOC(
+                    QAT_HASH_CHUNK_SZ, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+                if (own == NULL) {
+                    return MEMORY_E;
+                }
+                own->refCnt = 1;
+                XMEMCPY(QAT_HASH_CHUNK_DATA(own), QAT_HASH_CHUNK_DATA(chunk),
+                    used);
+                IntelQaHashChunkRelease(dev, chunk);
+                chunk = own;
+                dev->qat.op.hash.chunks[dev->qat.op.hash.chunkCnt - 1] = chunk;
+            }
+        }
+
+        len = QAT_HASH_CHUNK_CAP - used;
+        if (len > sz)
+            len = sz;
+        XMEMCPY(QAT_HASH_CHUNK_DATA(chunk) + used, in, len);
+        dev->qat.op.hash.inSz += len;
+        in += len;
+        sz -= len;
+    }
+
+    return 0;
+}
+
 static void IntelQaSymHashFree(WC_ASYNC_DEV* dev)
 {
     IntelQaSymCtx* ctx = &dev->qat.op.hash.ctx;
@@ -2636,28 +4512,29 @@ static void IntelQaSymHashFree(WC_ASYNC_DEV* dev)
     }
 
     if (pDstBuffer) {
+        /* list starts with the cached chunks, which are released below */
         idx = pDstBuffer->numBuffers;
-        while (--idx >= 0) {
+        while (--idx >= (int)dev->qat.op.hash.chunkCnt) {
             if (pDstBuffer->pBuffers[idx].pData) {
                 XFREE(pDstBuffer->pBuffers[idx].pData, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
                 pDstBuffer->pBuffers[idx].pData = NULL;
             }
         }
 
-        XFREE(pDstBuffer, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+        /* list is the device buffer list and is kept */
+        pDstBuffer->numBuffers = 0;
+        dev->qat.op.hash.srcList = NULL;
     }
 
     /* if final */
     if (dev->qat.out) {
         int doFree = 0;
 
-        /* free any tmp input */
-        if (dev->qat.op.hash.tmpIn) {
-            XFREE(dev->qat.op.hash.tmpIn, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
-        }
-        dev->qat.op.hash.tmpIn = NULL;
-        dev->qat.op.hash.tmpInSz = 0;
-        dev->qat.op.hash.tmpInBufSz = 0;
+        /* release cached input */
+        IntelQaHashChunksFree(dev);
+    #ifdef QAT_HASH_ENABLE_PARTIAL
+        IntelQaHashStreamFree(dev);
+    #endif
 
         if (ctx->isCopy || ctx->symCtx != ctx->symCtxSrc) {
             doFree = 1;
@@ -2667,8 +4544,15 @@ static void IntelQaSymHashFree(WC_ASYNC_DEV* dev)
         printf("IntelQaSymHashFree: dev %p, doFree %d\n", dev, doFree);
     #endif
 
-        /* close session */
-        IntelQaSymClose(dev, doFree);
+    #ifndef QAT_NO_SYM_SESSION_CACHE
+        /* HMAC session is kept for the next final with the same key and is
+         * removed when the key changes or in IntelQaClose */
+        if (!ctx->isCached || dev->qat.ret != 0)
+    #endif
+        {
+            /* close session */
+            IntelQaSymClose(dev, doFree);
+        }
     }
 
     /* clear temp pointers */
@@ -2709,17 +4593,15 @@ static void IntelQaSymHashCallback(void *pCallbackTag, CpaStatus status,
     }
 
     /* set return code to mark complete */
-    dev->qat.ret = ret;
+    IntelQaOpComplete(dev, ret);
 }
 
 /* For hash update call with out == NULL */
 /* For hash final call with out != NULL */
 /* All input is cached in memory or only sent to hardware on final */
-#ifndef QAT_HASH_ALLOC_BLOCK_SZ
-    #define QAT_HASH_ALLOC_BLOCK_SZ 1024
-#endif
 static int IntelQaSymHashCache(WC_ASYNC_DEV* dev, byte* out, const byte* in,
-    word32 inOutSz, CpaCySymHashMode hashMode,
+    word32 inOutSz, const IntelQaSgBuf* sg, word32 sgCnt,
+    CpaCySymHashMode hashMode,
     CpaCySymHashAlgorithm hashAlgorithm,
 
     /* For HMAC auth mode only */
@@ -2730,16 +4612,15 @@ static int IntelQaSymHashCache(WC_ASYNC_DEV* dev, byte* out, const byte* in,
     CpaCySymOpData* opData = NULL;
     CpaCySymCbFunc callback = IntelQaSymHashCallback;
     CpaBufferList* srcList = NULL;
-    Cpa32U bufferListSize = 0;
     Cpa8U* digestBuf = NULL;
-    Cpa32U metaSize = 0;
     Cpa32U totalMsgSz = 0;
     Cpa32U blockSize;
     Cpa32U digestSize;
     CpaCySymPacketType packetType;
     IntelQaSymCtx* ctx;
     CpaCySymSessionSetupData setup;
-    const int bufferCount = 1;
+    int bufferCount, idx = 0;
+    word32 i;
 
     ret = IntelQaSymHashGetInfo(hashAlgorithm, &blockSize, &digestSize);
     if (ret != 0) {
@@ -2756,73 +4637,44 @@ static int IntelQaSymHashCache(WC_ASYNC_DEV* dev, byte* out, const byte* in,
 
     /* handle input processing */
     if (in) {
-        if (dev->qat.op.hash.tmpIn == NULL) {
-            dev->qat.op.hash.tmpInSz = 0;
-            dev->qat.op.hash.tmpInBufSz = (inOutSz + QAT_HASH_ALLOC_BLOCK_SZ - 1)
-                & ~(QAT_HASH_ALLOC_BLOCK_SZ - 1);
-            if (dev->qat.op.hash.tmpInBufSz == 0)
-                dev->qat.op.hash.tmpInBufSz = QAT_HASH_ALLOC_BLOCK_SZ;
-            dev->qat.op.hash.tmpIn = (byte*)XMALLOC(dev->qat.op.hash.tmpInBufSz,
-                dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
-            if (dev->qat.op.hash.tmpIn == NULL) {
-                ret = MEMORY_E; goto exit;
-            }
-        }
-        /* determine if we need to grow buffer */
-        else if ((dev->qat.op.hash.tmpInSz + inOutSz) >
-                                                dev->qat.op.hash.tmpInBufSz) {
-            byte* oldIn = dev->qat.op.hash.tmpIn;
-            dev->qat.op.hash.tmpInBufSz = (dev->qat.op.hash.tmpInSz + inOutSz +
-                QAT_HASH_ALLOC_BLOCK_SZ - 1) & ~(QAT_HASH_ALLOC_BLOCK_SZ - 1);
-
-             dev->qat.op.hash.tmpIn = (byte*)XMALLOC(dev->qat.op.hash.tmpInBufSz,
-                dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
-            if (dev->qat.op.hash.tmpIn == NULL) {
-                ret = MEMORY_E; goto exit;
-            }
-            XMEMCPY(dev->qat.op.hash.tmpIn, oldIn, dev->qat.op.hash.tmpInSz);
-            XFREE(oldIn, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
-        }
-
-        /* copy input to new buffer */
-        XMEMCPY(&dev->qat.op.hash.tmpIn[dev->qat.op.hash.tmpInSz], in, inOutSz);
-        dev->qat.op.hash.tmpInSz += inOutSz;
-
-        ret = 0; /* success */
+        ret = IntelQaHashChunksAdd(dev, in, inOutSz);
         goto exit;
     }
 
     /* handle output processing */
     packetType = CPA_CY_SYM_PACKET_TYPE_FULL;
 
-    /* get meta size */
-    status = cpaCyBufferListGetMetaSize(dev->qat.handle, bufferCount, &metaSize);
-    if (status != CPA_STATUS_SUCCESS && metaSize <= 0) {
-        ret = BUFFER_E; goto exit;
+    /* cached chunks then any final fragments, which are used in place */
+    bufferCount = (int)(dev->qat.op.hash.chunkCnt + sgCnt);
+    if (bufferCount == 0) {
+        bufferCount = 1; /* empty message */
     }
 
-    /* allocate buffer list */
-    bufferListSize = sizeof(CpaBufferList) +
-        (bufferCount * sizeof(CpaFlatBuffer)) + metaSize;
-    srcList = XMALLOC(bufferListSize, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+    /* device buffer list, grown if there are more chunks than fit */
+    srcList = IntelQaSymListGet(dev, bufferCount);
     if (srcList == NULL) {
         ret = MEMORY_E; goto exit;
     }
     dev->qat.op.hash.srcList = srcList;
-    XMEMSET(srcList, 0, bufferListSize);
-    srcList->pBuffers = (CpaFlatBuffer*)(
-        (byte*)srcList + sizeof(CpaBufferList));
-    srcList->pPrivateMetaData = (byte*)srcList + sizeof(CpaBufferList) +
-        (bufferCount * sizeof(CpaFlatBuffer));
 
-    srcList->numBuffers = bufferCount;
-    srcList->pBuffers[0].dataLenInBytes = dev->qat.op.hash.tmpInSz;
-    srcList->pBuffers[0].pData = dev->qat.op.hash.tmpIn;
-    totalMsgSz = dev->qat.op.hash.tmpInSz;
+    for (i = 0; i < dev->qat.op.hash.chunkCnt; i++, idx++) {
+        srcList->pBuffers[idx].pData =
+            QAT_HASH_CHUNK_DATA(dev->qat.op.hash.chunks[i]);
+        srcList->pBuffers[idx].dataLenInBytes =
+            (i + 1 < dev->qat.op.hash.chunkCnt) ? (word32)QAT_HASH_CHUNK_CAP :
+            dev->qat.op.hash.inSz - (i * (word32)QAT_HASH_CHUNK_CAP);
+    }
+    totalMsgSz = dev->qat.op.hash.inSz;
 
-    dev->qat.op.hash.tmpInSz = 0;
-    dev->qat.op.hash.tmpInBufSz = 0;
-    dev->qat.op.hash.tmpIn = NULL;
+    for (i = 0; i < sgCnt; i++, idx++) {
+        srcList->pBuffers[idx].pData = XREALLOC(sg[i].data, sg[i].len,
+            dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+        if (srcList->pBuffers[idx].pData == NULL) {
+            ret = MEMORY_E; goto exit;
+        }
+        srcList->pBuffers[idx].dataLenInBytes = sg[i].len;
+        totalMsgSz += sg[i].len;
+    }
 
     /* build output */
     if (out) {
@@ -2844,55 +4696,461 @@ static int IntelQaSymHashCache(WC_ASYNC_DEV* dev, byte* out, const byte* in,
     setup.hashSetupData.authModeSetupData.authKey = authKey;
     setup.hashSetupData.authModeSetupData.authKeyLenInBytes = authKeyLenInBytes;
 
-    /* open session */
-    ret = IntelQaSymOpen(dev, &setup, callback);
-    if (ret != 0) {
-        goto exit;
+#ifndef QAT_NO_SYM_SESSION_CACHE
+    /* reuse open HMAC session if algorithm and key are same */
+    if (ctx->isOpen && !IntelQaSymSessionMatch(ctx, &setup)) {
+        IntelQaSymClose(dev, 0);
+    }
+#endif
+
+    /* open session */
+    ret = IntelQaSymOpen(dev, &setup, callback);
+    if (ret != 0) {
+        goto exit;
+    }
+#ifndef QAT_NO_SYM_SESSION_CACHE
+    /* only HMAC sessions are kept, their key precompute is the costly part */
+    if (!ctx->isCached && hashMode == CPA_CY_SYM_HASH_MODE_AUTH) {
+        IntelQaSymSessionSave(ctx, &setup);
+    }
+#endif
+
+    /* operation data */
+    opData = &ctx->opData;
+    XMEMSET(opData, 0, sizeof(CpaCySymOpData));
+    opData->sessionCtx = ctx->symCtx;
+    opData->packetType = packetType;
+    opData->messageLenToHashInBytes = totalMsgSz;
+    opData->pDigestResult = digestBuf;
+
+    /* store info needed for output */
+    dev->qat.out = out;
+    dev->qat.outLen = inOutSz;
+    IntelQaOpInit(dev, IntelQaSymHashFree);
+
+    /* perform symmetric hash operation async */
+    /* use same buffer list for in-place operation */
+    do {
+        status = cpaCySymPerformOp(dev->qat.handle,
+                                   dev,
+                                   opData,
+                                   srcList,
+                                   srcList,
+                                   NULL);
+    } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_HASH_ASYNC, callback,
+        &retryCount));
+
+    if (ret == WC_PENDING_E)
+        return ret;
+
+exit:
+
+    if (ret != 0) {
+        printf("cpaCySymPerformOp Hash failed! dev %p, status %d, ret %d\n",
+            dev, status, ret);
+
+        /* handle cleanup */
+        IntelQaSymHashFree(dev);
+    }
+
+    return ret;
+}
+
+#ifdef QAT_HASH_ENABLE_PARTIAL
+
+/* Streaming hash: updates are copied into a ring of QAT_HASH_STREAM_DEPTH
+ * chunks and each full chunk is sent as a partial once more input arrives,
+ * without waiting for the response. The QAT driver queues partials for a
+ * session and processes them in order. The last chunk is always kept for the
+ * final, so it never has 0 length. */
+
+#ifndef QAT_HASH_ALLOC_BLOCK_SZ
+    #define QAT_HASH_ALLOC_BLOCK_SZ 1024
+#endif
+
+/* offsets in the LAC session for the hash state and partial state */
+#ifdef USE_LAC_SESSION_FOR_STRUCT_OFFSET
+    #define QAT_HASH_STATE_OFFSET \
+        ((word32)offsetof(lac_session_desc_t, hashStatePrefixBuffer))
+    #define QAT_HASH_PARTIAL_OFFSET \
+        ((word32)offsetof(lac_session_desc_t, partialState))
+#else
+    #define QAT_HASH_STATE_OFFSET   (41 * 16)
+    #define QAT_HASH_PARTIAL_OFFSET (28 * 16)
+#endif
+
+typedef struct IntelQaHashSlot {
+    struct IntelQaHashStream* stream;
+    CpaCySymOpData opData;
+    CpaBufferList* list;  /* NUMA, one flat buffer and meta data */
+    byte* data;           /* NUMA, chunk input */
+    word32 dataSz;
+    byte* digest;         /* NUMA, final only */
+    int busy;             /* partial waiting for response */
+    byte isFinal;
+} IntelQaHashSlot;
+
+typedef struct IntelQaHashStream {
+    WC_ASYNC_DEV* dev;
+    IntelQaHashSlot slots[QAT_HASH_STREAM_DEPTH];
+    byte* state;          /* hash state taken from copied stream */
+    word32 stateSz;
+    word32 chunkSz;
+    word32 fill;          /* input in current slot */
+    int next;             /* current slot */
+    int inFlight;         /* partials waiting for response */
+    int failed;           /* partial response was an error */
+    byte started;         /* session holds hash state */
+} IntelQaHashStream;
+
+static void IntelQaHashStreamCallback(void *pCallbackTag, CpaStatus status,
+    const CpaCySymOp operationType, void *pOpData, CpaBufferList *pDstBuffer,
+    CpaBoolean verifyResult)
+{
+    IntelQaHashSlot* slot = (IntelQaHashSlot*)pCallbackTag;
+    IntelQaHashStream* stream = slot->stream;
+    WC_ASYNC_DEV* dev = stream->dev;
+    int ret = ASYNC_OP_E;
+
+    (void)pOpData;
+    (void)verifyResult;
+    (void)pDstBuffer;
+    (void)operationType;
+
+#ifdef QAT_DEBUG
+    printf("IntelQaHashStreamCallback: dev %p, slot %p, final %d, status %d\n",
+        dev, slot, slot->isFinal, status);
+#endif
+
+    if (!slot->isFinal) {
+        if (status != CPA_STATUS_SUCCESS) {
+            __atomic_store_n(&stream->failed, 1, __ATOMIC_RELEASE);
+        }
+    #ifdef QAT_TRACK_INFLIGHT
+        __atomic_sub_fetch(&g_cyInFlight[dev->qat.devId], 1, __ATOMIC_RELEASE);
+    #endif
+        /* stream may be freed once nothing is in flight */
+        __atomic_store_n(&slot->busy, 0, __ATOMIC_RELEASE);
+        __atomic_sub_fetch(&stream->inFlight, 1, __ATOMIC_RELEASE);
+        return;
+    }
+
+    /* digest is wrong if any partial before it failed */
+    if (status == CPA_STATUS_SUCCESS &&
+            !__atomic_load_n(&stream->failed, __ATOMIC_ACQUIRE)) {
+        /* return digest */
+        if (dev->qat.out && dev->qat.outLen > 0) {
+            XMEMCPY(dev->qat.out, slot->digest, dev->qat.outLen);
+        }
+        ret = 0; /* success */
+    }
+
+    /* set return code to mark complete */
+    IntelQaOpComplete(dev, ret);
+}
+
+/* poll until slot is free, or until no partials are in flight for NULL */
+static void IntelQaHashStreamWait(WC_ASYNC_DEV* dev, IntelQaHashStream* stream,
+    IntelQaHashSlot* slot)
+{
+    while ((slot != NULL) ?
+            __atomic_load_n(&slot->busy, __ATOMIC_ACQUIRE) != 0 :
+            __atomic_load_n(&stream->inFlight, __ATOMIC_ACQUIRE) > 0) {
+        IntelQaPollDev(dev);
+    #ifndef WC_NO_ASYNC_THREADING
+        wc_AsyncThreadYield();
+    #endif
+    }
+}
+
+static IntelQaHashStream* IntelQaHashStreamNew(WC_ASYNC_DEV* dev,
+    word32 chunkSz)
+{
+    IntelQaHashStream* stream;
+    int i;
+
+    stream = (IntelQaHashStream*)XMALLOC(sizeof(IntelQaHashStream), dev->heap,
+        DYNAMIC_TYPE_ASYNC);
+    if (stream == NULL) {
+        return NULL;
+    }
+    XMEMSET(stream, 0, sizeof(IntelQaHashStream));
+    stream->dev = dev;
+    stream->chunkSz = chunkSz;
+    for (i = 0; i < QAT_HASH_STREAM_DEPTH; i++) {
+        stream->slots[i].stream = stream;
+    }
+
+    return stream;
+}
+
+static void IntelQaHashStreamFree(WC_ASYNC_DEV* dev)
+{
+    IntelQaHashStream* stream = dev->qat.op.hash.stream;
+    IntelQaHashSlot* slot;
+    int i;
+
+    if (stream == NULL) {
+        return;
+    }
+
+    /* hardware may still be reading chunks */
+    IntelQaHashStreamWait(dev, stream, NULL);
+
+    for (i = 0; i < QAT_HASH_STREAM_DEPTH; i++) {
+        slot = &stream->slots[i];
+        if (slot->data) {
+            XFREE(slot->data, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+        }
+        if (slot->list) {
+            XFREE(slot->list, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+        }
+        if (slot->digest) {
+            XFREE(slot->digest, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+        }
+    }
+    if (stream->state) {
+        ForceZero(stream->state, stream->stateSz);
+        XFREE(stream->state, dev->heap, DYNAMIC_TYPE_ASYNC);
+    }
+    XFREE(stream, dev->heap, DYNAMIC_TYPE_ASYNC);
+    dev->qat.op.hash.stream = NULL;
+}
+
+/* make sure current slot has a buffer list and room for sz bytes of input */
+static int IntelQaHashSlotGrow(WC_ASYNC_DEV* dev, IntelQaHashStream* stream,
+    IntelQaHashSlot* slot, word32 sz)
+{
+    CpaStatus status;
+    Cpa32U metaSize = 0;
+    word32 listSz, dataSz;
+    byte* data;
+
+    if (slot->list == NULL) {
+        status = cpaCyBufferListGetMetaSize(dev->qat.handle, 1, &metaSize);
+        if (status != CPA_STATUS_SUCCESS && metaSize <= 0) {
+            return BUFFER_E;
+        }
+        listSz = sizeof(CpaBufferList) + sizeof(CpaFlatBuffer) + metaSize;
+        slot->list = (CpaBufferList*)XMALLOC(listSz, dev->heap,
+            DYNAMIC_TYPE_ASYNC_NUMA);
+        if (slot->list == NULL) {
+            return MEMORY_E;
+        }
+        XMEMSET(slot->list, 0, listSz);
+        slot->list->pBuffers = (CpaFlatBuffer*)(
+            (byte*)slot->list + sizeof(CpaBufferList));
+        slot->list->pPrivateMetaData = (byte*)slot->list->pBuffers +
+            sizeof(CpaFlatBuffer);
+        slot->list->numBuffers = 1;
+    }
+
+    if (sz <= slot->dataSz) {
+        return 0;
+    }
+
+    /* short hashes only use what they need, streamed ones a full chunk */
+    dataSz = stream->chunkSz;
+    if (!stream->started && stream->state == NULL) {
+        dataSz = (sz + QAT_HASH_ALLOC_BLOCK_SZ - 1) &
+            ~(QAT_HASH_ALLOC_BLOCK_SZ - 1);
+        if (dataSz < slot->dataSz * 2)
+            dataSz = slot->dataSz * 2;
+        if (dataSz > stream->chunkSz)
+            dataSz = stream->chunkSz;
+    }
+
+    data = (byte*)XMALLOC(dataSz, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+    if (data == NULL) {
+        return MEMORY_E;
+    }
+    if (slot->data) {
+        XMEMCPY(data, slot->data, stream->fill);
+        XFREE(slot->data, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
+    }
+    slot->data = data;
+    slot->dataSz = dataSz;
+
+    return 0;
+}
+
+/* send current slot as a partial, or as the final packet */
+static int IntelQaHashStreamSubmit(WC_ASYNC_DEV* dev, IntelQaHashStream* stream,
+    const CpaCySymSessionSetupData* setup, byte isFinal)
+{
+    int ret = 0, retryCount = 0, i;
+    CpaStatus status;
+    CpaCySymCbFunc callback = IntelQaHashStreamCallback;
+    IntelQaSymCtx* ctx = &dev->qat.op.hash.ctx;
+    IntelQaHashSlot* slot = &stream->slots[stream->next];
+    CpaCySymPacketType packetType;
+
+#ifndef QAT_NO_SYM_SESSION_CACHE
+    /* new stream reuses open HMAC session if algorithm and key are same, a
+     * copied stream has its own session for the copied state */
+    if (ctx->isOpen && !stream->started && stream->state == NULL &&
+            !IntelQaSymSessionMatch(ctx, setup)) {
+        IntelQaSymClose(dev, 0);
+    }
+#endif
+
+    /* open session */
+    if (!ctx->isOpen) {
+        ret = IntelQaSymOpen(dev, (CpaCySymSessionSetupData*)setup, callback);
+        if (ret != 0) {
+            return ret;
+        }
+    #ifndef QAT_NO_SYM_SESSION_CACHE
+        /* only HMAC sessions are kept, their key precompute is the costly
+         * part */
+        if (!ctx->isCached && stream->state == NULL &&
+                setup->hashSetupData.hashMode == CPA_CY_SYM_HASH_MODE_AUTH) {
+            IntelQaSymSessionSave(ctx, setup);
+        }
+    #endif
+    }
+
+    if (stream->state) {
+        /* continue from copied hash state */
+        byte* symCtx = (byte*)ctx->symCtx;
+
+        if (ctx->symCtxSize < QAT_HASH_STATE_OFFSET + stream->stateSz) {
+            return ASYNC_OP_E;
+        }
+        XMEMCPY(&symCtx[QAT_HASH_STATE_OFFSET], stream->state,
+            stream->stateSz);
+
+        /* make sure partialState is partial, try + 16 alignments as well */
+        for (i = 0; i < 4; i++) {
+            word32* priorVal = (word32*)(symCtx + QAT_HASH_PARTIAL_OFFSET +
+                (i * 16));
+            if (*priorVal == CPA_CY_SYM_PACKET_TYPE_FULL) {
+                *priorVal = CPA_CY_SYM_PACKET_TYPE_PARTIAL;
+                break;
+            }
+        }
+
+        ForceZero(stream->state, stream->stateSz);
+        XFREE(stream->state, dev->heap, DYNAMIC_TYPE_ASYNC);
+        stream->state = NULL;
+        stream->stateSz = 0;
+        stream->started = 1;
+    }
+
+    if (isFinal) {
+        packetType = stream->started ? CPA_CY_SYM_PACKET_TYPE_LAST_PARTIAL :
+                                       CPA_CY_SYM_PACKET_TYPE_FULL;
+    }
+    else {
+        packetType = CPA_CY_SYM_PACKET_TYPE_PARTIAL;
     }
 
-    /* operation data */
-    opData = &ctx->opData;
-    XMEMSET(opData, 0, sizeof(CpaCySymOpData));
-    opData->sessionCtx = ctx->symCtx;
-    opData->packetType = packetType;
-    opData->messageLenToHashInBytes = totalMsgSz;
-    opData->pDigestResult = digestBuf;
+    slot->list->pBuffers[0].pData = slot->data;
+    slot->list->pBuffers[0].dataLenInBytes = stream->fill;
+    XMEMSET(&slot->opData, 0, sizeof(CpaCySymOpData));
+    slot->opData.sessionCtx = ctx->symCtx;
+    slot->opData.packetType = packetType;
+    slot->opData.messageLenToHashInBytes = stream->fill;
+    slot->opData.pDigestResult = isFinal ? slot->digest : NULL;
+    slot->isFinal = isFinal;
 
-    /* store info needed for output */
-    dev->qat.out = out;
-    dev->qat.outLen = inOutSz;
-    IntelQaOpInit(dev, IntelQaSymHashFree);
+    if (isFinal) {
+        /* when blocking the operation is finished (and stream freed) here */
+        do {
+            status = cpaCySymPerformOp(dev->qat.handle, slot, &slot->opData,
+                slot->list, slot->list, NULL);
+        } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_HASH_ASYNC,
+            callback, &retryCount));
 
-    /* perform symmetric hash operation async */
-    /* use same buffer list for in-place operation */
+        return ret;
+    }
+
+    __atomic_store_n(&slot->busy, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stream->inFlight, 1, __ATOMIC_RELAXED);
     do {
-        status = cpaCySymPerformOp(dev->qat.handle,
-                                   dev,
-                                   opData,
-                                   srcList,
-                                   srcList,
-                                   NULL);
-    } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_HASH_ASYNC, callback,
+        status = cpaCySymPerformOp(dev->qat.handle, slot, &slot->opData,
+            slot->list, slot->list, NULL);
+    } while (IntelQaHandleCpaStatus(dev, status, &ret, 1, callback,
         &retryCount));
 
-    if (ret == WC_PENDING_E)
+    if (ret != WC_PENDING_E) {
+        __atomic_store_n(&slot->busy, 0, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&stream->inFlight, 1, __ATOMIC_RELAXED);
         return ret;
+    }
+    stream->started = 1;
 
-exit:
+    /* move to next chunk, waiting for its previous partial if needed */
+    stream->next = (stream->next + 1) % QAT_HASH_STREAM_DEPTH;
+    stream->fill = 0;
+    IntelQaHashStreamWait(dev, stream, &stream->slots[stream->next]);
 
-    if (ret != 0) {
-        printf("cpaCySymPerformOp Hash failed! dev %p, status %d, ret %d\n",
-            dev, status, ret);
+    return 0;
+}
 
-        /* handle cleanup */
-        IntelQaSymHashFree(dev);
+/* give copy its own stream, starting from hash state of src */
+static int IntelQaHashStreamCopy(WC_ASYNC_DEV* src, WC_ASYNC_DEV* dst)
+{
+    int ret = 0;
+    IntelQaHashStream* srcStream = src->qat.op.hash.stream;
+    IntelQaHashStream* stream;
+    IntelQaSymCtx* ctxSrc = &src->qat.op.hash.ctx;
+    const byte* state = NULL;
+    word32 stateSz = 0;
+
+    stream = IntelQaHashStreamNew(dst, srcStream->chunkSz);
+    if (stream == NULL) {
+        dst->qat.op.hash.stream = NULL;
+        return MEMORY_E;
+    }
+    dst->qat.op.hash.stream = stream;
+    /* state is taken now, so copy does not depend on src session */
+    dst->qat.op.hash.ctx.symCtxSrc = NULL;
+
+    /* session hash state is current once all partials are done */
+    IntelQaHashStreamWait(src, srcStream, NULL);
+    if (__atomic_load_n(&srcStream->failed, __ATOMIC_ACQUIRE)) {
+        ret = ASYNC_OP_E; goto exit;
+    }
+
+    if (srcStream->state) {
+        state = srcStream->state;
+        stateSz = srcStream->stateSz;
+    }
+    else if (srcStream->started && ctxSrc->symCtx != NULL &&
+                                ctxSrc->symCtxSize > QAT_HASH_STATE_OFFSET) {
+        state = (const byte*)ctxSrc->symCtx + QAT_HASH_STATE_OFFSET;
+        stateSz = ctxSrc->symCtxSize - QAT_HASH_STATE_OFFSET;
+    }
+    if (state) {
+        stream->state = (byte*)XMALLOC(stateSz, dst->heap, DYNAMIC_TYPE_ASYNC);
+        if (stream->state == NULL) {
+            ret = MEMORY_E; goto exit;
+        }
+        XMEMCPY(stream->state, state, stateSz);
+        stream->stateSz = stateSz;
+    }
+
+    /* input not yet sent */
+    if (srcStream->fill > 0) {
+        ret = IntelQaHashSlotGrow(dst, stream, &stream->slots[0],
+            srcStream->fill);
+        if (ret != 0) {
+            goto exit;
+        }
+        XMEMCPY(stream->slots[0].data,
+            srcStream->slots[srcStream->next].data, srcStream->fill);
+        stream->fill = srcStream->fill;
+    }
+
+exit:
+    if (ret != 0) {
+        IntelQaHashStreamFree(dst);
     }
 
     return ret;
 }
 
-#ifdef QAT_HASH_ENABLE_PARTIAL
-
 /* For hash update call with out == NULL */
 /* For hash final call with out != NULL */
 static int IntelQaSymHashPartial(WC_ASYNC_DEV* dev, byte* out, const byte* in,
@@ -2902,24 +5160,13 @@ static int IntelQaSymHashPartial(WC_ASYNC_DEV* dev, byte* out, const byte* in,
     /* For HMAC auth mode only */
     Cpa8U* authKey, Cpa32U authKeyLenInBytes)
 {
-    int ret, retryCount = 0, i;
-    CpaStatus status = CPA_STATUS_SUCCESS;
-    CpaCySymOpData* opData = NULL;
-    CpaCySymCbFunc callback = IntelQaSymHashCallback;
-    CpaBufferList* srcList = NULL;
-    Cpa32U bufferListSize = 0;
-    Cpa8U* digestBuf = NULL;
-    Cpa32U metaSize = 0;
-    Cpa32U totalMsgSz = 0;
+    int ret;
     Cpa32U blockSize;
     Cpa32U digestSize;
-    CpaCySymPacketType packetType;
-    IntelQaSymCtx* ctx;
     CpaCySymSessionSetupData setup;
-
-    int* bufferCount;
-    byte** buffers;
-    word32* buffersSz;
+    IntelQaHashStream* stream;
+    IntelQaHashSlot* slot;
+    word32 len;
 
     ret = IntelQaSymHashGetInfo(hashAlgorithm, &blockSize, &digestSize);
     if (ret != 0) {
@@ -2932,291 +5179,114 @@ static int IntelQaSymHashPartial(WC_ASYNC_DEV* dev, byte* out, const byte* in,
         dev, out, in, inOutSz, hashMode, hashAlgorithm, digestSize, blockSize);
 #endif
 
-    ctx = &dev->qat.op.hash.ctx;
-
-    bufferCount = &dev->qat.op.hash.bufferCount;
-    buffers = dev->qat.op.hash.buffers;
-    buffersSz = dev->qat.op.hash.buffersSz;
-
-    /* handle input processing */
-    if (in) {
-        /* if tmp has data or input is not block aligned */
-        if (dev->qat.op.hash.tmpInSz > 0 || inOutSz == 0 ||
-            (inOutSz % blockSize) != 0) {
-            /* need to handle unaligned hashing, using local tmp */
-
-            /* make sure we have tmpIn allocated */
-            if (dev->qat.op.hash.tmpIn == NULL) {
-                dev->qat.op.hash.tmpInSz = 0;
-                dev->qat.op.hash.tmpIn = XMALLOC(blockSize, dev->heap,
-                    DYNAMIC_TYPE_ASYNC_NUMA);
-                if (dev->qat.op.hash.tmpIn == NULL) {
-                    ret = MEMORY_E; goto exit;
-                }
-                dev->qat.op.hash.tmpInBufSz = blockSize;
-            }
-
-            /* setup processing for block aligned part of input or use tmpIn */
-            if (dev->qat.op.hash.tmpInSz > 0) {
-                word32 remainSz = blockSize - dev->qat.op.hash.tmpInSz;
-
-                /* attempt to fill tmpIn and process block */
-                if (inOutSz < remainSz) {
-                    /* not enough to fill buffer */
-                    XMEMCPY(&dev->qat.op.hash.tmpIn[dev->qat.op.hash.tmpInSz], in, inOutSz);
-                    dev->qat.op.hash.tmpInSz += inOutSz;
-                }
-                else {
-                    /* fill tmp buffer and add */
-                    XMEMCPY(&dev->qat.op.hash.tmpIn[dev->qat.op.hash.tmpInSz], in, remainSz);
-                    dev->qat.op.hash.tmpInSz += remainSz;
-                    buffers[*bufferCount] = dev->qat.op.hash.tmpIn;
-                    buffersSz[*bufferCount] = dev->qat.op.hash.tmpInSz;
-                    (*bufferCount)++;
-                    inOutSz -= remainSz;
-                    in += remainSz;
-                    dev->qat.op.hash.tmpIn = NULL;
-                    dev->qat.op.hash.tmpInSz = 0;
-
-                    /* use remainder of block aligned */
-                    if (inOutSz >= blockSize) {
-                        word32 unalignedSz = (inOutSz % blockSize);
-                        word32 inSz = inOutSz - unalignedSz;
-
-                        buffersSz[*bufferCount] = inSz;
-                        buffers[*bufferCount] = (byte*)XMALLOC(inSz,
-                                    dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
-                        if (buffers[*bufferCount] == NULL) {
-                            ret = MEMORY_E; goto exit;
-                        }
-                        XMEMCPY(buffers[*bufferCount], (byte*)in, inSz);
-
-                        (*bufferCount)++;
-                        inOutSz -= inSz;
-                        in += inSz;
-                    }
-
-                    /* save remainder to tmpIn */
-                    if (inOutSz > 0) {
-                        dev->qat.op.hash.tmpInSz = 0;
-                        dev->qat.op.hash.tmpIn = XMALLOC(blockSize, dev->heap,
-                            DYNAMIC_TYPE_ASYNC_NUMA);
-                        if (dev->qat.op.hash.tmpIn == NULL) {
-                            ret = MEMORY_E; goto exit;
-                        }
-                        dev->qat.op.hash.tmpInBufSz = blockSize;
-
-                        XMEMCPY(dev->qat.op.hash.tmpIn, in, inOutSz);
-                        dev->qat.op.hash.tmpInSz = inOutSz;
-                    }
-                }
-            }
-            else {
-                /* if not enough to fit into blockSize store into tmpIn */
-                if (inOutSz < blockSize) {
-                    dev->qat.op.hash.tmpInSz = inOutSz;
-                    XMEMCPY(dev->qat.op.hash.tmpIn, in, inOutSz);
-                }
-                else {
-                    word32 unalignedSz = (inOutSz % blockSize);
-                    word32 inSz = inOutSz - unalignedSz;
-
-                    buffersSz[*bufferCount] = inSz;
-                    buffers[*bufferCount] = (byte*)XREALLOC((byte*)in,
-                        inSz, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
-                    if (buffers[*bufferCount] == NULL) {
-                        ret = MEMORY_E; goto exit;
-                    }
-                    (*bufferCount)++;
-
-                    /* store remainder */
-                    dev->qat.op.hash.tmpInSz = unalignedSz;
-                    XMEMCPY(dev->qat.op.hash.tmpIn, &in[inSz], unalignedSz);
-                }
-            }
-
-        }
-        else {
-            /* use input directly */
-            buffersSz[*bufferCount] = inOutSz;
-            buffers[*bufferCount] = (byte*)XREALLOC((byte*)in,
-                buffersSz[*bufferCount], dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
-            if (buffers[*bufferCount] == NULL) {
-                ret = MEMORY_E; goto exit;
-            }
-            (*bufferCount)++;
-        }
-    }
-
-    /* determine if early exit is okay */
-    if (out == NULL) {
-        /* if not final and no in buffers then exit with success */
-        if (*bufferCount == 0) {
-            ret = 0; /* return success */
-            goto exit;
-        }
-
-        /* for auth must pass in buffer, so leave one in buffer cache */
-        else if (hashMode == CPA_CY_SYM_HASH_MODE_AUTH && *bufferCount <= 1) {
-            ret = 0; /* return success */
-            goto exit;
-        }
-    }
-
-    /* determine packet type and add any remainder to input processing */
-    packetType = CPA_CY_SYM_PACKET_TYPE_PARTIAL;
-    if (out) {
-        /* if remainder then add it */
-        if (dev->qat.op.hash.tmpIn) {
-            /* add buffer and use final hash type */
-            buffers[*bufferCount] = dev->qat.op.hash.tmpIn;
-            buffersSz[*bufferCount] = dev->qat.op.hash.tmpInSz;
-            (*bufferCount)++;
-            dev->qat.op.hash.tmpIn = NULL;
-            dev->qat.op.hash.tmpInSz = 0;
-        }
-
-        /* determine if this is full or partial */
-        if (ctx->symCtxSrc == NULL || (!ctx->isOpen && !ctx->isCopy)) {
-            packetType = CPA_CY_SYM_PACKET_TYPE_FULL;
-        }
-        else {
-            packetType = CPA_CY_SYM_PACKET_TYPE_LAST_PARTIAL;
+    stream = dev->qat.op.hash.stream;
+    if (stream == NULL) {
+        /* partials must be a multiple of the block size */
+        len = QAT_HASH_STREAM_CHUNK - (QAT_HASH_STREAM_CHUNK % blockSize);
+        stream = IntelQaHashStreamNew(dev, (len > 0) ? len : blockSize);
+        if (stream == NULL) {
+            return MEMORY_E;
         }
+        dev->qat.op.hash.stream = stream;
+        dev->qat.op.hash.srcList = NULL;
     }
-
-    /* get meta size */
-    status = cpaCyBufferListGetMetaSize(dev->qat.handle, *bufferCount, &metaSize);
-    if (status != CPA_STATUS_SUCCESS && metaSize <= 0) {
-        ret = BUFFER_E; goto exit;
-    }
-
-    /* allocate buffer list */
-    bufferListSize = sizeof(CpaBufferList) +
-        (*bufferCount * sizeof(CpaFlatBuffer)) + metaSize;
-    srcList = XMALLOC(bufferListSize, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
-    if (srcList == NULL) {
-        ret = MEMORY_E; goto exit;
-    }
-    dev->qat.op.hash.srcList = srcList;
-    XMEMSET(srcList, 0, bufferListSize);
-    srcList->pBuffers = (CpaFlatBuffer*)(
-        (byte*)srcList + sizeof(CpaBufferList));
-    srcList->pPrivateMetaData = (byte*)srcList + sizeof(CpaBufferList) +
-        (*bufferCount * sizeof(CpaFlatBuffer));
-    for (i = 0; i < *bufferCount; i++) {
-        srcList->pBuffers[i].dataLenInBytes = buffersSz[i];
-        srcList->pBuffers[i].pData = buffers[i];
-        totalMsgSz += buffersSz[i];
-    }
-    srcList->numBuffers = *bufferCount;
-
-    /* clear buffer cache */
-    dev->qat.op.hash.bufferCount = 0;
-    for (i=0; i<MAX_QAT_HASH_BUFFERS; i++) {
-        dev->qat.op.hash.buffers[i] = NULL;
-        dev->qat.op.hash.buffersSz[i] = 0;
-    }
-
-    /* build output */
-    if (out) {
-        /* use blockSize for alloc, but we are only returning digestSize */
-        digestBuf = XMALLOC(blockSize, dev->heap, DYNAMIC_TYPE_ASYNC_NUMA);
-        if (digestBuf == NULL) {
-            ret = MEMORY_E; goto exit;
-        }
+    if (__atomic_load_n(&stream->failed, __ATOMIC_ACQUIRE)) {
+        ret = ASYNC_OP_E; goto exit;
     }
 
     /* setup */
     XMEMSET(&setup, 0, sizeof(CpaCySymSessionSetupData));
     setup.sessionPriority = CPA_CY_PRIORITY_NORMAL;
     setup.symOperation = CPA_CY_SYM_OP_HASH;
-    setup.partialsNotRequired = (packetType == CPA_CY_SYM_PACKET_TYPE_FULL) ?
-        CPA_TRUE : CPA_FALSE;
+    setup.partialsNotRequired = CPA_FALSE;
     setup.hashSetupData.hashMode = hashMode;
     setup.hashSetupData.hashAlgorithm = hashAlgorithm;
     setup.hashSetupData.digestResultLenInBytes = digestSize;
     setup.hashSetupData.authModeSetupData.authKey = authKey;
     setup.hashSetupData.authModeSetupData.authKeyLenInBytes = authKeyLenInBytes;
 
-    /* open session */
-    ret = IntelQaSymOpen(dev, &setup, callback);
-    if (ret != 0) {
-        goto exit;
-    }
-
-    /* workarounds for handling symmetric context copies */
-    if (packetType == CPA_CY_SYM_PACKET_TYPE_LAST_PARTIAL) {
-        /* set the partialState for partial  */
-    #ifdef USE_LAC_SESSION_FOR_STRUCT_OFFSET
-        word32 parStaOffset = (word32)offsetof(lac_session_desc_t, partialState);
-    #else
-        word32 parStaOffset = (28 * 16);
-    #endif
+    /* handle input processing */
+    if (in) {
+        while (inOutSz > 0) {
+            /* chunk is full and more input follows, so send it */
+            if (stream->fill == stream->chunkSz) {
+                ret = IntelQaHashStreamSubmit(dev, stream, &setup, 0);
+                if (ret != 0) {
+                    goto exit;
+                }
+            }
 
-        /* make sure partialState is partial, try + 16 alignments as well */
-        for (i = 0; i < 4; i++) {
-            word32* priorVal = (word32*)((byte*)ctx->symCtx + parStaOffset + (i * 16));
-            if (*priorVal == CPA_CY_SYM_PACKET_TYPE_FULL) {
-                *priorVal = CPA_CY_SYM_PACKET_TYPE_PARTIAL;
-                break;
+            slot = &stream->slots[stream->next];
+            len = stream->chunkSz - stream->fill;
+            if (len > inOutSz)
+                len = inOutSz;
+            ret = IntelQaHashSlotGrow(dev, stream, slot, stream->fill + len);
+            if (ret != 0) {
+                goto exit;
             }
+            XMEMCPY(&slot->data[stream->fill], in, len);
+            stream->fill += len;
+            in += len;
+            inOutSz -= len;
         }
-    }
-    if (ctx->symCtx != ctx->symCtxSrc) {
-        /* copy hash state (digest into new symmetric context) */
-        byte* symCtxDst = (byte*)ctx->symCtx;
-        byte* symCtxSrc = (byte*)ctx->symCtxSrc;
-        /* copy from hashStatePrefixBuffer to end */
-    #ifdef USE_LAC_SESSION_FOR_STRUCT_OFFSET
-        const word32 copyRegion = (word32)offsetof(lac_session_desc_t, hashStatePrefixBuffer);
-    #else
-        const word32 copyRegion = (41 * 16);
-    #endif
-        XMEMCPY(&symCtxDst[copyRegion], &symCtxSrc[copyRegion],
-            ctx->symCtxSize - copyRegion);
+
+        ret = 0; /* success */
+        goto exit;
     }
 
-    /* operation data */
-    opData = &ctx->opData;
-    XMEMSET(opData, 0, sizeof(CpaCySymOpData));
-    opData->sessionCtx = ctx->symCtx;
-    opData->packetType = packetType;
-    opData->messageLenToHashInBytes = totalMsgSz;
-    opData->pDigestResult = digestBuf;
+    /* handle output processing */
+    slot = &stream->slots[stream->next];
+    ret = IntelQaHashSlotGrow(dev, stream, slot, stream->fill);
+    if (ret != 0) {
+        goto exit;
+    }
+    if (slot->digest == NULL) {
+        /* use blockSize for alloc, but we are only returning digestSize */
+        slot->digest = (byte*)XMALLOC(blockSize, dev->heap,
+            DYNAMIC_TYPE_ASYNC_NUMA);
+        if (slot->digest == NULL) {
+            ret = MEMORY_E; goto exit;
+        }
+    }
 
     /* store info needed for output */
     dev->qat.out = out;
     dev->qat.outLen = inOutSz;
     IntelQaOpInit(dev, IntelQaSymHashFree);
 
-    /* perform symmetric hash operation async */
-    /* use same buffer list for in-place operation */
-    do {
-        status = cpaCySymPerformOp(dev->qat.handle,
-                                   dev,
-                                   opData,
-                                   srcList,
-                                   srcList,
-                                   NULL);
-    } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_HASH_ASYNC, callback,
-        &retryCount));
-
+    ret = IntelQaHashStreamSubmit(dev, stream, &setup, 1);
     if (ret == WC_PENDING_E)
         return ret;
 
 exit:
 
     if (ret != 0) {
-        printf("cpaCySymPerformOp Hash partial failed! dev %p, status %d, ret %d\n",
-            dev, status, ret);
+        printf("cpaCySymPerformOp Hash partial failed! dev %p, ret %d\n",
+            dev, ret);
 
-        /* handle cleanup */
+        /* hash state is lost */
+    #ifndef QAT_NO_SYM_SESSION_CACHE
+        /* session may hold partial state, do not reuse it */
+        dev->qat.op.hash.ctx.isCached = 0;
+    #endif
+        IntelQaHashStreamFree(dev);
         IntelQaSymHashFree(dev);
     }
 
     return ret;
 }
+
+/* streaming is used when hardware supports partials for the algorithm */
+static int IntelQaSymHashUseStream(CpaCySymHashAlgorithm hashAlgorithm)
+{
+    (void)hashAlgorithm;
+
+    return g_qatCapabilities.supPartial
+    #ifdef QAT_V2
+        && hashAlgorithm != CPA_CY_SYM_HASH_SHA3_256
+    #endif
+        ;
+}
 #endif /* QAT_HASH_ENABLE_PARTIAL */
 
 
@@ -3241,20 +5311,58 @@ static int IntelQaSymHash(WC_ASYNC_DEV* dev, byte* out, const byte* in,
     }
 
 #ifdef QAT_HASH_ENABLE_PARTIAL
-    if (g_qatCapabilities.supPartial
-    #ifdef QAT_V2
-        && hashAlgorithm != CPA_CY_SYM_HASH_SHA3_256
-    #endif
-    ) {
+    if (IntelQaSymHashUseStream(hashAlgorithm)) {
         return IntelQaSymHashPartial(dev, out, in, inOutSz, hashMode,
             hashAlgorithm, authKey, authKeyLenInBytes);
     }
     else
 #endif
-    return IntelQaSymHashCache(dev, out, in, inOutSz, hashMode,
+    return IntelQaSymHashCache(dev, out, in, inOutSz, NULL, 0, hashMode,
         hashAlgorithm, authKey, authKeyLenInBytes);
 }
 
+/* final hash of any cached updates followed by fragments, without copying
+ * the fragments together */
+int IntelQaSymHashSg(WC_ASYNC_DEV* dev, byte* out, const IntelQaSgBuf* sg,
+    word32 sgCnt, CpaCySymHashAlgorithm hashAlgorithm)
+{
+    int ret;
+    word32 i;
+    Cpa32U blockSize, digestSize;
+
+    /* check args */
+    if (dev == NULL || out == NULL || (sg == NULL && sgCnt > 0) ||
+                                                sgCnt > QAT_SG_MAX_BUFFERS) {
+        return BAD_FUNC_ARG;
+    }
+    for (i = 0; i < sgCnt; i++) {
+        if (sg[i].data == NULL || sg[i].len == 0) {
+            return BAD_FUNC_ARG;
+        }
+    }
+    ret = IntelQaSymHashGetInfo(hashAlgorithm, &blockSize, &digestSize);
+    if (ret != 0) {
+        return BAD_FUNC_ARG;
+    }
+#ifdef QAT_HASH_ENABLE_PARTIAL
+    if (IntelQaSymHashUseStream(hashAlgorithm)) {
+        /* updates are streamed, so fragments are added as updates */
+        for (i = 0; i < sgCnt; i++) {
+            ret = IntelQaSymHashPartial(dev, NULL, sg[i].data, sg[i].len,
+                CPA_CY_SYM_HASH_MODE_PLAIN, hashAlgorithm, NULL, 0);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+        return IntelQaSymHashPartial(dev, out, NULL, digestSize,
+            CPA_CY_SYM_HASH_MODE_PLAIN, hashAlgorithm, NULL, 0);
+    }
+#endif
+
+    return IntelQaSymHashCache(dev, out, NULL, digestSize, sg, sgCnt,
+        CPA_CY_SYM_HASH_MODE_PLAIN, hashAlgorithm, NULL, 0);
+}
+
 #ifdef WOLFSSL_SHA512
 int IntelQaSymSha512(WC_ASYNC_DEV* dev, byte* out, const byte* in, word32 sz)
 {
@@ -3474,7 +5582,14 @@ static void IntelQaEccPointMulCallback(void *pCallbackTag, CpaStatus status,
     (void)opData;
 
     /* set return code to mark complete */
-    dev->qat.ret = ret;
+    IntelQaOpComplete(dev, ret);
+}
+
+static CpaStatus IntelQaEccPointMulSubmit(WC_ASYNC_DEV* dev)
+{
+    return cpaCyEcPointMultiply(dev->qat.handle, IntelQaEccPointMulCallback, dev,
+        &dev->qat.op.ecc_mul.opData, &dev->qat.op.ecc_mul.multiplyStatus,
+        &dev->qat.op.ecc_mul.pXk, &dev->qat.op.ecc_mul.pYk);
 }
 
 int IntelQaEccPointMul(WC_ASYNC_DEV* dev, WC_BIGINT* k,
@@ -3548,16 +5663,16 @@ int IntelQaEccPointMul(WC_ASYNC_DEV* dev, WC_BIGINT* k,
     dev->qat.op.ecc_mul.pubY = pubY;
     dev->qat.op.ecc_mul.pubZ = pubZ;
     IntelQaOpInit(dev, IntelQaEccPointMulFree);
+    IntelQaSchedule(dev);
 
     /* perform point multiply */
+#ifdef WC_ASYNC_BATCH_SUBMIT
+    if (IntelQaBatchAdd(dev, IntelQaEccPointMulSubmit, QAT_ECMUL_ASYNC)) {
+        return WC_PENDING_E; /* submitted by wolfAsync_BatchSubmit */
+    }
+#endif
     do {
-        status = cpaCyEcPointMultiply(dev->qat.handle,
-            callback,
-            dev,
-            opData,
-            multiplyStatus,
-            pXk,
-            pYk);
+        status = IntelQaEccPointMulSubmit(dev);
     } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_ECMUL_ASYNC, callback,
         &retryCount));
 
@@ -3654,7 +5769,14 @@ static void IntelQaEcdhCallback(void *pCallbackTag, CpaStatus status,
     (void)pYk;
 
     /* set return code to mark complete */
-    dev->qat.ret = ret;
+    IntelQaOpComplete(dev, ret);
+}
+
+static CpaStatus IntelQaEcdhSubmit(WC_ASYNC_DEV* dev)
+{
+    return cpaCyEcdhPointMultiply(dev->qat.handle, IntelQaEcdhCallback, dev,
+        &dev->qat.op.ecc_ecdh.opData, &dev->qat.op.ecc_ecdh.multiplyStatus,
+        &dev->qat.op.ecc_ecdh.pXk, &dev->qat.op.ecc_ecdh.pYk);
 }
 
 int IntelQaEcdh(WC_ASYNC_DEV* dev, WC_BIGINT* k, WC_BIGINT* xG,
@@ -3727,16 +5849,16 @@ int IntelQaEcdh(WC_ASYNC_DEV* dev, WC_BIGINT* k, WC_BIGINT* xG,
     dev->qat.out = out;
     dev->qat.outLenPtr = outlen;
     IntelQaOpInit(dev, IntelQaEcdhFree);
+    IntelQaSchedule(dev);
 
     /* perform point multiply */
+#ifdef WC_ASYNC_BATCH_SUBMIT
+    if (IntelQaBatchAdd(dev, IntelQaEcdhSubmit, QAT_ECDHE_ASYNC)) {
+        return WC_PENDING_E; /* submitted by wolfAsync_BatchSubmit */
+    }
+#endif
     do {
-        status = cpaCyEcdhPointMultiply(dev->qat.handle,
-            callback,
-            dev,
-            opData,
-            multiplyStatus,
-            pXk,
-            pYk);
+        status = IntelQaEcdhSubmit(dev);
     } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_ECDHE_ASYNC, callback,
         &retryCount));
 
@@ -3819,7 +5941,14 @@ static void IntelQaEcdsaSignCallback(void *pCallbackTag,
     (void)opData;
 
     /* set return code to mark complete */
-    dev->qat.ret = ret;
+    IntelQaOpComplete(dev, ret);
+}
+
+static CpaStatus IntelQaEcdsaSignSubmit(WC_ASYNC_DEV* dev)
+{
+    return cpaCyEcdsaSignRS(dev->qat.handle, IntelQaEcdsaSignCallback, dev,
+        &dev->qat.op.ecc_sign.opData, &dev->qat.op.ecc_sign.signStatus,
+        &dev->qat.op.ecc_sign.R, &dev->qat.op.ecc_sign.S);
 }
 
 int IntelQaEcdsaSign(WC_ASYNC_DEV* dev,
@@ -3886,16 +6015,16 @@ int IntelQaEcdsaSign(WC_ASYNC_DEV* dev,
     dev->qat.op.ecc_sign.pR = r;
     dev->qat.op.ecc_sign.pS = s;
     IntelQaOpInit(dev, IntelQaEcdsaSignFree);
+    IntelQaSchedule(dev);
 
     /* Perform ECDSA sign */
+#ifdef WC_ASYNC_BATCH_SUBMIT
+    if (IntelQaBatchAdd(dev, IntelQaEcdsaSignSubmit, QAT_ECDSA_ASYNC)) {
+        return WC_PENDING_E; /* submitted by wolfAsync_BatchSubmit */
+    }
+#endif
     do {
-        status = cpaCyEcdsaSignRS(dev->qat.handle,
-            callback,
-            dev,
-            opData,
-            signStatus,
-            pR,
-            pS);
+        status = IntelQaEcdsaSignSubmit(dev);
     } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_ECDSA_ASYNC, callback,
         &retryCount));
 
@@ -3960,7 +6089,13 @@ static void IntelQaEcdsaVerifyCallback(void *pCallbackTag,
     (void)opData;
 
     /* set return code to mark complete */
-    dev->qat.ret = ret;
+    IntelQaOpComplete(dev, ret);
+}
+
+static CpaStatus IntelQaEcdsaVerifySubmit(WC_ASYNC_DEV* dev)
+{
+    return cpaCyEcdsaVerify(dev->qat.handle, IntelQaEcdsaVerifyCallback, dev,
+        &dev->qat.op.ecc_verify.opData, &dev->qat.op.ecc_verify.verifyStatus);
 }
 
 int IntelQaEcdsaVerify(WC_ASYNC_DEV* dev, WC_BIGINT* m,
@@ -4012,14 +6147,16 @@ int IntelQaEcdsaVerify(WC_ASYNC_DEV* dev, WC_BIGINT* m,
     /* store info needed for output */
     dev->qat.op.ecc_verify.stat = pVerifyStatus;
     IntelQaOpInit(dev, IntelQaEcdsaVerifyFree);
+    IntelQaSchedule(dev);
 
     /* Perform ECDSA verify */
+#ifdef WC_ASYNC_BATCH_SUBMIT
+    if (IntelQaBatchAdd(dev, IntelQaEcdsaVerifySubmit, QAT_ECDSA_ASYNC)) {
+        return WC_PENDING_E; /* submitted by wolfAsync_BatchSubmit */
+    }
+#endif
     do {
-        status = cpaCyEcdsaVerify(dev->qat.handle,
-            callback,
-            dev,
-            opData,
-            verifyStatus);
+        status = IntelQaEcdsaVerifySubmit(dev);
     } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_ECDSA_ASYNC, callback,
         &retryCount));
 
@@ -4100,7 +6237,13 @@ static void IntelQaDhKeyGenCallback(void *pCallbackTag, CpaStatus status,
     (void)opData;
 
     /* set return code to mark complete */
-    dev->qat.ret = ret;
+    IntelQaOpComplete(dev, ret);
+}
+
+static CpaStatus IntelQaDhKeyGenSubmit(WC_ASYNC_DEV* dev)
+{
+    return cpaCyDhKeyGenPhase1(dev->qat.handle, IntelQaDhKeyGenCallback, dev,
+        &dev->qat.op.dh_gen.opData, &dev->qat.op.dh_gen.pOut);
 }
 
 int IntelQaDhKeyGen(WC_ASYNC_DEV* dev, WC_BIGINT* p, WC_BIGINT* g,
@@ -4151,14 +6294,16 @@ int IntelQaDhKeyGen(WC_ASYNC_DEV* dev, WC_BIGINT* p, WC_BIGINT* g,
     dev->qat.out = pub;
     dev->qat.outLenPtr = pubSz;
     IntelQaOpInit(dev, IntelQaDhKeyGenFree);
+    IntelQaSchedule(dev);
 
     /* Perform DhKeyGen */
+#ifdef WC_ASYNC_BATCH_SUBMIT
+    if (IntelQaBatchAdd(dev, IntelQaDhKeyGenSubmit, QAT_DH_ASYNC)) {
+        return WC_PENDING_E; /* submitted by wolfAsync_BatchSubmit */
+    }
+#endif
     do {
-        status = cpaCyDhKeyGenPhase1(dev->qat.handle,
-            callback,
-            dev,
-            opData,
-            pOut);
+        status = IntelQaDhKeyGenSubmit(dev);
     } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_DH_ASYNC, callback,
         &retryCount));
 
@@ -4253,7 +6398,13 @@ static void IntelQaDhAgreeCallback(void *pCallbackTag, CpaStatus status,
     (void)opData;
 
     /* set return code to mark complete */
-    dev->qat.ret = ret;
+    IntelQaOpComplete(dev, ret);
+}
+
+static CpaStatus IntelQaDhAgreeSubmit(WC_ASYNC_DEV* dev)
+{
+    return cpaCyDhKeyGenPhase2Secret(dev->qat.handle, IntelQaDhAgreeCallback, dev,
+        &dev->qat.op.dh_agree.opData, &dev->qat.op.dh_agree.pOut);
 }
 
 int IntelQaDhAgree(WC_ASYNC_DEV* dev, WC_BIGINT* p,
@@ -4305,14 +6456,16 @@ int IntelQaDhAgree(WC_ASYNC_DEV* dev, WC_BIGINT* p,
     dev->qat.out = agree;
     dev->qat.outLenPtr = agreeSz;
     IntelQaOpInit(dev, IntelQaDhAgreeFree);
+    IntelQaSchedule(dev);
 
     /* Perform DhKeyGen */
+#ifdef WC_ASYNC_BATCH_SUBMIT
+    if (IntelQaBatchAdd(dev, IntelQaDhAgreeSubmit, QAT_DH_ASYNC)) {
+        return WC_PENDING_E; /* submitted by wolfAsync_BatchSubmit */
+    }
+#endif
     do {
-        status = cpaCyDhKeyGenPhase2Secret(dev->qat.handle,
-            callback,
-            dev,
-            opData,
-            pOut);
+        status = IntelQaDhAgreeSubmit(dev);
     } while (IntelQaHandleCpaStatus(dev, status, &ret, QAT_DH_ASYNC, callback,
         &retryCount));
 
@@ -4489,7 +6642,7 @@ static void IntelQaDrbgCallback(void *pCallbackTag, CpaStatus status,
     (void)opData;
 
     /* set return code to mark complete */
-    dev->qat.ret = ret;
+    IntelQaOpComplete(dev, ret);
 }
 
 int IntelQaDrbg(WC_ASYNC_DEV* dev, byte* rngBuf, word32 rngSz)
@@ -62,6 +62,26 @@
     #include <icp_sal_iommu.h>
 #endif
 
+/* enable per-thread size-class caches for NUMA allocations */
+#ifdef USE_QAE_SLAB
+    #ifdef WOLFSSL_TRACK_MEMORY
+        /* tracker reports cached blocks as leaks */
+        #undef USE_QAE_SLAB
+    #endif
+#endif
+#ifdef USE_QAE_SLAB
+    #define QAE_SLAB_CLASSES    5
+    #ifndef QAE_SLAB_CACHE_MAX
+        #define QAE_SLAB_CACHE_MAX  64   /* blocks per class in thread cache */
+    #endif
+    #ifndef QAE_SLAB_BATCH
+        #define QAE_SLAB_BATCH      16   /* blocks moved to/from depot */
+    #endif
+    #ifndef QAE_SLAB_DEPOT_MAX
+        #define QAE_SLAB_DEPOT_MAX  1024 /* blocks per class in shared depot */
+    #endif
+#endif
+
 /* enable fixed static memory instead of dynamic list */
 #ifdef USE_QAE_STATIC_MEM
     /* adjustable parameter for the maximum memory allocations */
@@ -176,7 +196,9 @@ typedef struct qaeMemHeader {
     size_t size;
     word16 count;
     word16 isNuma:1;
-    word16 reservedBits:15; /* use for future bits */
+    word16 isSlab:1;    /* returned to slab cache on free */
+    word16 slabClass:3;
+    word16 reservedBits:11; /* use for future bits */
     word16 type;
     word16 numa_page_offset; /* use QAE_NOT_NUMA_PAGE if not NUMA */
 } ALIGN16 qaeMemHeader;
@@ -221,6 +243,41 @@ typedef struct qaeMemHeader {
 static int g_qaeMemFd = -1;
 #endif /* !QAT_V2 */
 
+/* registered DMA buffer pools */
+typedef struct qaeMemPool {
+    byte* base; /* NULL when slot is free */
+    byte* end;
+} qaeMemPool;
+static qaeMemPool g_memPools[QAT_MEM_POOL_MAX];
+static int g_memPoolCount = 0; /* slots in use, including freed ones */
+static pthread_mutex_t g_memPoolLock = PTHREAD_MUTEX_INITIALIZER;
+
+#ifdef USE_QAE_SLAB
+    /* free blocks are linked through their first bytes */
+    typedef struct qaeSlabList {
+        void* head;
+        word32 count;
+    } qaeSlabList;
+
+    static const word32 g_slabSizes[QAE_SLAB_CLASSES] = {
+        64,     /* operation metadata */
+        256,    /* big integers */
+        512,
+        4096,   /* data buffers */
+        16384,  /* TLS records */
+    };
+    static THREAD_LS_T qaeSlabList g_slabCache[QAE_SLAB_CLASSES];
+    static THREAD_LS_T int g_slabCacheInit = 0;
+    /* shared depot, blocks spilled from or freed by other threads */
+    static qaeSlabList g_slabDepot[QAE_SLAB_CLASSES];
+    static pthread_mutex_t g_slabLock = PTHREAD_MUTEX_INITIALIZER;
+    static pthread_key_t g_slabKey;
+    static pthread_once_t g_slabKeyOnce = PTHREAD_ONCE_INIT;
+#endif
+
+/* NUMA node for this thread's allocations */
+static THREAD_LS_T int g_qaeMemNode = 0;
+
 #ifdef WOLFSSL_TRACK_MEMORY
     static qaeMemStats g_memStats;
     static qaeMemList g_memList;
@@ -273,6 +330,24 @@ static WC_INLINE int qaeMemTypeIsNuma(int type)
     return isNuma;
 }
 
+/* returns 1 if the buffer is inside a registered pool */
+static WC_INLINE int qaeMemPoolContains(const void* ptr, size_t size)
+{
+    int i, count;
+    const byte* p = (const byte*)ptr;
+    byte* base;
+
+    count = __atomic_load_n(&g_memPoolCount, __ATOMIC_ACQUIRE);
+    for (i = 0; i < count; i++) {
+        base = __atomic_load_n(&g_memPools[i].base, __ATOMIC_ACQUIRE);
+        if (base != NULL && p >= base && p < g_memPools[i].end &&
+                size <= (size_t)(g_memPools[i].end - p)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 
 static void _qaeMemFree(void *ptr, void* heap, int type
 #ifdef WOLFSSL_DEBUG_MEMORY
@@ -398,14 +473,14 @@ static void* _qaeMemAlloc(size_t size, void* heap, int type
 
     /* allocate type */
     if (isNuma) {
-        /* Node is typically 0 */
+        /* node of instance used by this thread, typically 0 */
     #ifdef QAT_V2
         page_offset = 0;
-        ptr = qaeMemAllocNUMA((Cpa32U)(size + sizeof(qaeMemHeader)), 0,
-            alignment);
+        ptr = qaeMemAllocNUMA((Cpa32U)(size + sizeof(qaeMemHeader)),
+            (Cpa32U)g_qaeMemNode, alignment);
     #else
-        ptr = qaeMemAllocNUMA((Cpa32U)(size + sizeof(qaeMemHeader)), 0,
-            alignment, &page_offset);
+        ptr = qaeMemAllocNUMA((Cpa32U)(size + sizeof(qaeMemHeader)),
+            (Cpa32U)g_qaeMemNode, alignment, &page_offset);
     #endif
     }
     else {
@@ -473,7 +548,221 @@ static void* _qaeMemAlloc(size_t size, void* heap, int type
     return ptr;
 }
 
+#ifdef USE_QAE_SLAB
+static WC_INLINE int qaeSlabClass(size_t size)
+{
+    int i;
+    for (i = 0; i < QAE_SLAB_CLASSES; i++) {
+        if (size <= g_slabSizes[i])
+            return i;
+    }
+    return -1;
+}
+
+static WC_INLINE qaeMemHeader* qaeSlabHeader(void* ptr)
+{
+    return (qaeMemHeader*)((byte*)ptr - sizeof(qaeMemHeader));
+}
+
+/* return blocks to NUMA allocator */
+static void qaeSlabRelease(void* list)
+{
+    void* ptr;
+
+#ifndef USE_QAE_THREAD_LS
+    if (list == NULL || pthread_mutex_lock(&g_memLock) != 0) {
+        return;
+    }
+#endif
+
+    while (list != NULL) {
+        ptr = list;
+        list = *(void**)ptr;
+        qaeSlabHeader(ptr)->isSlab = 0;
+        qaeSlabHeader(ptr)->count = 1;
+        _qaeMemFree(ptr, NULL, DYNAMIC_TYPE_ASYNC_NUMA64
+        #ifdef WOLFSSL_DEBUG_MEMORY
+            , __func__, __LINE__
+        #endif
+        );
+    }
+
+#ifndef USE_QAE_THREAD_LS
+    pthread_mutex_unlock(&g_memLock);
+#endif
+}
+
+/* move up to count blocks from one list to another */
+static void qaeSlabMove(qaeSlabList* from, qaeSlabList* to, word32 count)
+{
+    void* ptr;
+
+    while (count-- > 0 && from->head != NULL) {
+        ptr = from->head;
+        from->head = *(void**)ptr;
+        from->count--;
+        *(void**)ptr = to->head;
+        to->head = ptr;
+        to->count++;
+    }
+}
+
+/* spill all of this thread's cached blocks into depot */
+static void qaeSlabCacheFlush(void* arg)
+{
+    int i;
+    qaeSlabList* cache = (qaeSlabList*)arg;
+    qaeSlabList excess;
+
+    if (cache == NULL || pthread_mutex_lock(&g_slabLock) != 0) {
+        return;
+    }
+    XMEMSET(&excess, 0, sizeof(excess));
+    for (i = 0; i < QAE_SLAB_CLASSES; i++) {
+        qaeSlabMove(&cache[i], &g_slabDepot[i], cache[i].count);
+        if (g_slabDepot[i].count > QAE_SLAB_DEPOT_MAX) {
+            qaeSlabMove(&g_slabDepot[i], &excess,
+                g_slabDepot[i].count - QAE_SLAB_DEPOT_MAX);
+        }
+    }
+    pthread_mutex_unlock(&g_slabLock);
+
+    qaeSlabRelease(excess.head);
+}
+
+static void qaeSlabKeyInit(void)
+{
+    /* flush cache when thread exits */
+    pthread_key_create(&g_slabKey, qaeSlabCacheFlush);
+}
+
+/* register thread cache to be flushed on thread exit */
+static WC_INLINE void qaeSlabCacheInit(void)
+{
+    if (!g_slabCacheInit) {
+        g_slabCacheInit = 1;
+        pthread_once(&g_slabKeyOnce, qaeSlabKeyInit);
+        pthread_setspecific(g_slabKey, g_slabCache);
+    }
+}
+
+/* get cached block of class, NULL if none */
+static void* qaeSlabGet(int cls, void* heap, int type)
+{
+    qaeSlabList* cache = &g_slabCache[cls];
+    qaeMemHeader* header;
+    void* ptr;
+
+    if (cache->head == NULL) {
+        /* refill from depot */
+        if (__atomic_load_n(&g_slabDepot[cls].head, __ATOMIC_RELAXED) == NULL ||
+                pthread_mutex_lock(&g_slabLock) != 0) {
+            return NULL;
+        }
+        qaeSlabMove(&g_slabDepot[cls], cache, QAE_SLAB_BATCH);
+        pthread_mutex_unlock(&g_slabLock);
+        if (cache->head == NULL) {
+            return NULL;
+        }
+    }
+
+    ptr = cache->head;
+    cache->head = *(void**)ptr;
+    cache->count--;
+
+    header = qaeSlabHeader(ptr);
+    header->heap = heap;
+    header->type = type;
+    header->count = 1;
+#ifdef USE_QAE_THREAD_LS
+    header->threadId = pthread_self();
+#endif
+
+    return ptr;
+}
+
+/* mark new block so it is cached on free */
+static void qaeSlabMark(void* ptr, int cls)
+{
+    qaeMemHeader* header = qaeSlabHeader(ptr);
+
+    header->isSlab = 1;
+    header->slabClass = cls;
+
+    qaeSlabCacheInit();
+}
+
+/* returns 1 if block was a slab block, it is cached once unreferenced */
+static int qaeSlabPut(void* ptr)
+{
+    qaeMemHeader* header;
+    qaeSlabList* cache;
+    qaeSlabList excess;
+    int cls;
+
+    if (((size_t)ptr % WOLF_HEADER_ALIGN) != 0) {
+        return 0;
+    }
+    header = qaeSlabHeader(ptr);
+    if (header->magic != WOLF_MAGIC_NUM || !header->isSlab) {
+        return 0;
+    }
+    if (__atomic_sub_fetch(&header->count, 1, __ATOMIC_ACQ_REL) > 0) {
+        return 1; /* still in use */
+    }
+
+    cls = header->slabClass;
+    cache = &g_slabCache[cls];
+    *(void**)ptr = cache->head;
+    cache->head = ptr;
+    cache->count++;
+
+    qaeSlabCacheInit();
+
+    if (cache->count > QAE_SLAB_CACHE_MAX) {
+        /* spill to depot for other threads */
+        XMEMSET(&excess, 0, sizeof(excess));
+        if (pthread_mutex_lock(&g_slabLock) == 0) {
+            qaeSlabMove(cache, &g_slabDepot[cls], QAE_SLAB_BATCH);
+            if (g_slabDepot[cls].count > QAE_SLAB_DEPOT_MAX) {
+                qaeSlabMove(&g_slabDepot[cls], &excess,
+                    g_slabDepot[cls].count - QAE_SLAB_DEPOT_MAX);
+            }
+            pthread_mutex_unlock(&g_slabLock);
+        }
+        qaeSlabRelease(excess.head);
+    }
+
+    return 1;
+}
+
+/* release cached blocks of calling thread and depot */
+void IntelQaMemSlabFree(void)
+{
+    int i;
+    void* list = NULL;
+    qaeSlabList all;
+
+    qaeSlabCacheFlush(g_slabCache);
+
+    XMEMSET(&all, 0, sizeof(all));
+    if (pthread_mutex_lock(&g_slabLock) == 0) {
+        for (i = 0; i < QAE_SLAB_CLASSES; i++) {
+            qaeSlabMove(&g_slabDepot[i], &all, g_slabDepot[i].count);
+        }
+        pthread_mutex_unlock(&g_slabLock);
+        list = all.head;
+    }
+    qaeSlabRelease(list);
+}
+#endif /* USE_QAE_SLAB */
+
 /* Public Functions */
+void IntelQaMemSetNode(int node)
+{
+    g_qaeMemNode = (node >= 0) ? node : 0;
+}
+
 void* IntelQaMalloc(size_t size, void* heap, int type
 #ifdef WOLFSSL_DEBUG_MEMORY
     , const char* func, unsigned int line
@@ -481,9 +770,24 @@ void* IntelQaMalloc(size_t size, void* heap, int type
 )
 {
     void* ptr;
+#ifndef USE_QAE_THREAD_LS
+    int ret;
+#endif
+#ifdef USE_QAE_SLAB
+    int cls = qaeMemTypeIsNuma(type) ? qaeSlabClass(size) : -1;
+
+    if (cls >= 0) {
+        ptr = qaeSlabGet(cls, heap, type);
+        if (ptr != NULL) {
+            return ptr;
+        }
+        /* new block is full class size so it can be recycled */
+        size = g_slabSizes[cls];
+    }
+#endif
 
 #ifndef USE_QAE_THREAD_LS
-    int ret = pthread_mutex_lock(&g_memLock);
+    ret = pthread_mutex_lock(&g_memLock);
     if (ret != 0) {
         printf("Alloc: Error(%d) on mutex lock\n", ret);
         return NULL;
@@ -500,6 +804,12 @@ void* IntelQaMalloc(size_t size, void* heap, int type
     pthread_mutex_unlock(&g_memLock);
 #endif
 
+#ifdef USE_QAE_SLAB
+    if (ptr != NULL && cls >= 0) {
+        qaeSlabMark(ptr, cls);
+    }
+#endif
+
     return ptr;
 }
 
@@ -510,7 +820,21 @@ void IntelQaFree(void *ptr, void* heap, int type
 )
 {
 #ifndef USE_QAE_THREAD_LS
-    int ret = pthread_mutex_lock(&g_memLock);
+    int ret;
+#endif
+
+    /* pool buffers are owned by the application */
+    if (ptr && qaeMemPoolContains(ptr, 1)) {
+        return;
+    }
+#ifdef USE_QAE_SLAB
+    if (ptr && qaeSlabPut(ptr)) {
+        return;
+    }
+#endif
+
+#ifndef USE_QAE_THREAD_LS
+    ret = pthread_mutex_lock(&g_memLock);
     if (ret != 0) {
         printf("Free: Error(%d) on mutex lock\n", ret);
         return;
@@ -540,9 +864,17 @@ void* IntelQaRealloc(void *ptr, size_t size, void* heap, int type
     byte allocNew = 1;
     int newIsNuma = -1, ptrIsNuma = -1;
     size_t copySize = 0;
+#ifndef USE_QAE_THREAD_LS
+    int ret;
+#endif
+
+    /* buffer in registered pool is already DMA-able, use in place */
+    if (ptr && qaeMemTypeIsNuma(type) && qaeMemPoolContains(ptr, size)) {
+        return ptr;
+    }
 
 #ifndef USE_QAE_THREAD_LS
-    int ret = pthread_mutex_lock(&g_memLock);
+    ret = pthread_mutex_lock(&g_memLock);
     if (ret != 0) {
         printf("Realloc: Error(%d) on mutex lock\n", ret);
         return NULL;
@@ -582,7 +914,7 @@ void* IntelQaRealloc(void *ptr, size_t size, void* heap, int type
             #endif
                 {
                     /* use existing pointer and increment counter */
-                    header->count++;
+                    __atomic_add_fetch(&header->count, 1, __ATOMIC_ACQ_REL);
                     newPtr = origPtr;
                     allocNew = 0;
                 }
@@ -596,11 +928,27 @@ void* IntelQaRealloc(void *ptr, size_t size, void* heap, int type
     }
 
     if (allocNew) {
-        newPtr = _qaeMemAlloc(size, heap, type
-        #ifdef WOLFSSL_DEBUG_MEMORY
-            , func, line
+    #ifdef USE_QAE_SLAB
+        int cls = qaeMemTypeIsNuma(type) ? qaeSlabClass(size) : -1;
+        newPtr = (cls >= 0) ? qaeSlabGet(cls, heap, type) : NULL;
+        if (newPtr == NULL)
+    #endif
+        {
+            newPtr = _qaeMemAlloc(
+            #ifdef USE_QAE_SLAB
+                (cls >= 0) ? g_slabSizes[cls] :
+            #endif
+                size, heap, type
+            #ifdef WOLFSSL_DEBUG_MEMORY
+                , func, line
+            #endif
+            );
+        #ifdef USE_QAE_SLAB
+            if (newPtr != NULL && cls >= 0) {
+                qaeSlabMark(newPtr, cls);
+            }
         #endif
-        );
+        }
         if (newPtr && ptr) {
             /* only copy min of new and old size to new pointer */
             if (copySize > size)
@@ -641,6 +989,78 @@ void* IntelQaRealloc(void *ptr, size_t size, void* heap, int type
     return newPtr;
 }
 
+int IntelQaMemRegisterPool(void* base, size_t size)
+{
+    int i, ret = 0, slot = -1;
+
+    if (base == NULL || size == 0 ||
+            (size_t)base + size < (size_t)base) {
+        return BAD_FUNC_ARG;
+    }
+
+    if (pthread_mutex_lock(&g_memPoolLock) != 0) {
+        return BAD_MUTEX_E;
+    }
+
+    for (i = 0; i < g_memPoolCount; i++) {
+        if (g_memPools[i].base == NULL) {
+            if (slot < 0)
+                slot = i;
+        }
+        else if ((byte*)base < g_memPools[i].end &&
+                 (byte*)base + size > g_memPools[i].base) {
+            ret = BAD_FUNC_ARG; /* overlaps existing pool */
+            break;
+        }
+    }
+    if (ret == 0 && slot < 0) {
+        if (g_memPoolCount < QAT_MEM_POOL_MAX) {
+            slot = g_memPoolCount;
+        }
+        else {
+            ret = MEMORY_E;
+        }
+    }
+    if (ret == 0) {
+        /* publish base last so readers see a complete entry */
+        g_memPools[slot].end = (byte*)base + size;
+        __atomic_store_n(&g_memPools[slot].base, (byte*)base,
+            __ATOMIC_RELEASE);
+        if (slot == g_memPoolCount) {
+            __atomic_store_n(&g_memPoolCount, slot + 1, __ATOMIC_RELEASE);
+        }
+    }
+
+    pthread_mutex_unlock(&g_memPoolLock);
+
+    return ret;
+}
+
+/* no operation may still be using a buffer from the pool */
+int IntelQaMemUnregisterPool(void* base)
+{
+    int i, ret = BAD_FUNC_ARG;
+
+    if (base == NULL) {
+        return BAD_FUNC_ARG;
+    }
+
+    if (pthread_mutex_lock(&g_memPoolLock) != 0) {
+        return BAD_MUTEX_E;
+    }
+
+    for (i = 0; i < g_memPoolCount; i++) {
+        if (g_memPools[i].base == (byte*)base) {
+            __atomic_store_n(&g_memPools[i].base, NULL, __ATOMIC_RELEASE);
+            ret = 0;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&g_memPoolLock);
+
+    return ret;
+}
 
 #ifdef WOLFSSL_TRACK_MEMORY
 int InitMemoryTracker(void)
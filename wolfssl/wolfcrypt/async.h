@@ -39,6 +39,43 @@
 struct WC_ASYNC_DEV;
 
 
+/* Software worker pool: WC_ASYNC_SW_THREADS threads run queued SW operations
+ * instead of the polling thread (0 = one per CPU) */
+#if defined(WC_ASYNC_SW_THREADS) && (!defined(WOLFSSL_ASYNC_CRYPT_SW) || \
+    defined(WC_NO_ASYNC_THREADING) || defined(SINGLE_THREADED))
+    #undef WC_ASYNC_SW_THREADS
+#endif
+
+/* Poll budget: each wolfAsync_EventQueuePoll steps pending SW operations
+ * round-robin for up to WC_ASYNC_SW_POLL_BUDGET microseconds */
+#if defined(WC_ASYNC_SW_POLL_BUDGET) && defined(WC_ASYNC_SW_THREADS)
+    /* pooled work is run to completion by the workers, nothing to step */
+    #error WC_ASYNC_SW_POLL_BUDGET cannot be used with WC_ASYNC_SW_THREADS
+#endif
+#if defined(WC_ASYNC_SW_POLL_BUDGET) && !defined(WOLFSSL_ASYNC_CRYPT_SW)
+    #undef WC_ASYNC_SW_POLL_BUDGET
+#endif
+
+/* ECDH batching: the queue poller finishes pending SW ECDH shared secrets on
+ * the same curve together, sharing one (RNG blinded) modular inversion */
+#if defined(WC_ASYNC_SW_ECDH_BATCH) && (defined(WC_ASYNC_SW_THREADS) || \
+    defined(WC_ASYNC_SW_POLL_BUDGET))
+    /* batch runs on the poller, workers or budget steps would race it */
+    #error WC_ASYNC_SW_ECDH_BATCH cannot be used with WC_ASYNC_SW_THREADS or \
+        WC_ASYNC_SW_POLL_BUDGET
+#endif
+#if defined(WC_ASYNC_SW_ECDH_BATCH) && (!defined(WOLFSSL_ASYNC_CRYPT_SW) || \
+    !defined(HAVE_ECC) || !defined(HAVE_ECC_DHE) || \
+    !defined(ECC_TIMING_RESISTANT) || defined(WC_NO_RNG) || \
+    defined(WOLFSSL_ECC_BLIND_K) || defined(WOLFSSL_SP_MATH))
+    #undef WC_ASYNC_SW_ECDH_BATCH
+#endif
+#ifdef WC_ASYNC_SW_ECDH_BATCH
+    #ifndef WC_ASYNC_SW_ECDH_BATCH_MAX
+        #define WC_ASYNC_SW_ECDH_BATCH_MAX 16 /* operations run together */
+    #endif
+#endif
+
 /* Asyncronous crypto using software */
 #ifdef WOLFSSL_ASYNC_CRYPT_SW
     enum WC_ASYNC_SW_TYPE {
@@ -76,11 +113,27 @@ struct WC_ASYNC_DEV;
         ASYNC_SW_AES_GCM_DECRYPT  = 12,
         #endif
     #endif /* HAVE_AESGCM */
+    #ifdef HAVE_AESCCM
+        ASYNC_SW_AES_CCM_ENCRYPT  = 15,
+        #ifdef HAVE_AES_DECRYPT
+        ASYNC_SW_AES_CCM_DECRYPT  = 16,
+        #endif
+    #endif /* HAVE_AESCCM */
+    #ifdef WOLFSSL_AES_XTS
+        ASYNC_SW_AES_XTS_ENCRYPT  = 17,
+        #ifdef HAVE_AES_DECRYPT
+        ASYNC_SW_AES_XTS_DECRYPT  = 18,
+        #endif
+    #endif /* WOLFSSL_AES_XTS */
 #endif /* !NO_AES */
 #ifndef NO_DES3
         ASYNC_SW_DES3_CBC_ENCRYPT = 13,
         ASYNC_SW_DES3_CBC_DECRYPT = 14,
 #endif /* !NO_DES3 */
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+        ASYNC_SW_CHACHA20_POLY1305_ENCRYPT = 19,
+        ASYNC_SW_CHACHA20_POLY1305_DECRYPT = 20,
+#endif
     };
 
 #ifdef HAVE_ECC
@@ -155,12 +208,12 @@ struct WC_ASYNC_DEV;
 
 #ifndef NO_AES
     struct AsyncCryptSwAes {
-        void* aes; /* Aes */
+        void* aes; /* Aes, or XtsAes for XTS */
         byte* out;
         const byte* in;
         word32 sz;
-    #ifdef HAVE_AESGCM
-        const byte* iv;
+    #if defined(HAVE_AESGCM) || defined(HAVE_AESCCM) || defined(WOLFSSL_AES_XTS)
+        const byte* iv; /* nonce for CCM, tweak for XTS */
         word32 ivSz;
         byte* authTag;
         word32 authTagSz;
@@ -179,6 +232,19 @@ struct WC_ASYNC_DEV;
     };
 #endif /* !NO_DES3 */
 
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+    struct AsyncCryptSwChaChaPoly {
+        const byte* key;
+        const byte* iv;
+        const byte* authIn;
+        word32 authInSz;
+        const byte* in;
+        word32 sz;
+        byte* out;
+        byte* authTag;
+    };
+#endif /* HAVE_CHACHA && HAVE_POLY1305 */
+
     #ifdef __CC_ARM
         #pragma push
         #pragma anon_unions
@@ -211,10 +277,21 @@ struct WC_ASYNC_DEV;
     #ifndef NO_DES3
         struct AsyncCryptSwDes des;
     #endif /* !NO_DES3 */
+    #if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+        struct AsyncCryptSwChaChaPoly chachaPoly;
+    #endif
     #if HAVE_ANONYMOUS_INLINE_AGGREGATES
         }; /* union */
     #endif
         byte type; /* enum WC_ASYNC_SW_TYPE */
+    #ifdef WC_ASYNC_SW_THREADS
+        byte poolState; /* idle, queued or done */
+        int poolRet; /* result from worker */
+        struct WC_ASYNC_DEV* poolNext; /* worker pool job list */
+    #endif
+    #ifdef WC_ASYNC_SW_POLL_BUDGET
+        word32 budgetRound; /* last pass this operation was stepped in */
+    #endif
     } WC_ASYNC_SW;
 
     #ifdef __CC_ARM
@@ -241,6 +318,48 @@ struct WC_ASYNC_DEV;
     #endif
 #endif
 
+/* Completion notification: a pollable file descriptor per device, readable
+ * when completions (or SW work) are ready */
+#if defined(WC_ASYNC_EVENTFD) && !defined(HAVE_INTEL_QA) && \
+    !defined(WOLFSSL_ASYNC_CRYPT_SW)
+    #undef WC_ASYNC_EVENTFD
+#endif
+
+/* Completion ring: backends push finished events to a bounded lock-free ring
+ * so wolfAsync_EventQueuePoll only visits completed events. Needs a backend
+ * that finishes operations on its own (QAT callbacks or SW worker pool) */
+#if defined(WC_ASYNC_COMPLETION_RING) && !defined(HAVE_INTEL_QA) && \
+    !defined(WC_ASYNC_SW_THREADS)
+    #error WC_ASYNC_COMPLETION_RING requires HAVE_INTEL_QA or WC_ASYNC_SW_THREADS
+#endif
+#ifdef WC_ASYNC_COMPLETION_RING
+    #ifndef WC_ASYNC_RING_SIZE
+        #define WC_ASYNC_RING_SIZE          4096 /* rounded up to power of 2 */
+    #endif
+
+    typedef struct WC_ASYNC_RING_SLOT {
+        word32              seq;
+        WOLF_EVENT*         event;
+    } WC_ASYNC_RING_SLOT;
+
+    typedef struct WC_ASYNC_RING {
+        WOLF_EVENT_QUEUE*   queue;
+        void*               heap;
+        WC_ASYNC_RING_SLOT* slots;
+        WOLF_EVENT**        ready;      /* completed, not yet returned */
+        word32              size;
+        word32              readyCount;
+        word32              head;       /* next slot for producers */
+        word32              tail;       /* next slot for consumer */
+        word32              count;      /* devices tracked by ring */
+        word32              untracked;  /* events queued while ring full */
+    #if defined(HAVE_INTEL_QA) && !defined(QAT_USE_POLLING_THREAD)
+        word32              inst[QAT_POLL_MAX_INSTANCES]; /* tracked devices
+                                                           * per instance */
+    #endif
+    } WC_ASYNC_RING;
+#endif /* WC_ASYNC_COMPLETION_RING */
+
 /* async thresholds - defaults */
 #ifdef WC_ASYNC_THRESH_NONE
     #undef  WC_ASYNC_THRESH_AES_CBC
@@ -251,6 +370,15 @@ struct WC_ASYNC_DEV;
 
     #undef  WC_ASYNC_THRESH_DES3_CBC
     #define WC_ASYNC_THRESH_DES3_CBC 1
+
+    #undef  WC_ASYNC_THRESH_AES_CCM
+    #define WC_ASYNC_THRESH_AES_CCM  1
+
+    #undef  WC_ASYNC_THRESH_AES_XTS
+    #define WC_ASYNC_THRESH_AES_XTS  1
+
+    #undef  WC_ASYNC_THRESH_CHACHA_POLY
+    #define WC_ASYNC_THRESH_CHACHA_POLY 1
 #else
     #ifndef WC_ASYNC_THRESH_AES_CBC
         #define WC_ASYNC_THRESH_AES_CBC 1024
@@ -261,8 +389,78 @@ struct WC_ASYNC_DEV;
     #ifndef WC_ASYNC_THRESH_DES3_CBC
         #define WC_ASYNC_THRESH_DES3_CBC 1024
     #endif
+    #ifndef WC_ASYNC_THRESH_AES_CCM
+        #define WC_ASYNC_THRESH_AES_CCM 128
+    #endif
+    #ifndef WC_ASYNC_THRESH_AES_XTS
+        #define WC_ASYNC_THRESH_AES_XTS 1024
+    #endif
+    /* ChaCha20 is fast in software, offload only larger records */
+    #ifndef WC_ASYNC_THRESH_CHACHA_POLY
+        #define WC_ASYNC_THRESH_CHACHA_POLY 1024
+    #endif
 #endif /* WC_ASYNC_THRESH_NONE */
 
+/* learn thresholds at runtime by timing software against the device */
+#if defined(WC_ASYNC_THRESH_CALIBRATE) && !defined(WC_ASYNC_THRESH_NONE)
+    #ifndef WC_ASYNC_CAL_MIN_SZ
+        #define WC_ASYNC_CAL_MIN_SZ  64    /* smallest size bucket */
+    #endif
+    #ifndef WC_ASYNC_CAL_MAX_SZ
+        #define WC_ASYNC_CAL_MAX_SZ  16384 /* largest size bucket */
+    #endif
+    #ifndef WC_ASYNC_CAL_ITERS
+        #define WC_ASYNC_CAL_ITERS   16    /* operations timed per bucket */
+    #endif
+    #ifndef WC_ASYNC_CAL_DEPTH
+        #define WC_ASYNC_CAL_DEPTH   8     /* device operations in flight */
+    #endif
+
+    /* threshold that keeps an algorithm in software */
+    #define WC_ASYNC_THRESH_SW_ONLY  0xFFFFFFFFU
+
+    enum {
+        WC_ASYNC_THRESH_ID_AES_CBC = 0,
+        WC_ASYNC_THRESH_ID_AES_GCM,
+        WC_ASYNC_THRESH_ID_DES3_CBC,
+        WC_ASYNC_THRESH_ID_AES_CCM,
+        WC_ASYNC_THRESH_ID_AES_XTS,
+        WC_ASYNC_THRESH_ID_CHACHA_POLY,
+        WC_ASYNC_THRESH_ID_COUNT
+    };
+
+    /* configured values are used until calibrated */
+    enum {
+        WC_ASYNC_THRESH_DEF_AES_CBC  = WC_ASYNC_THRESH_AES_CBC,
+        WC_ASYNC_THRESH_DEF_AES_GCM  = WC_ASYNC_THRESH_AES_GCM,
+        WC_ASYNC_THRESH_DEF_DES3_CBC = WC_ASYNC_THRESH_DES3_CBC,
+        WC_ASYNC_THRESH_DEF_AES_CCM  = WC_ASYNC_THRESH_AES_CCM,
+        WC_ASYNC_THRESH_DEF_AES_XTS  = WC_ASYNC_THRESH_AES_XTS,
+        WC_ASYNC_THRESH_DEF_CHACHA_POLY = WC_ASYNC_THRESH_CHACHA_POLY
+    };
+
+    #undef  WC_ASYNC_THRESH_AES_CBC
+    #define WC_ASYNC_THRESH_AES_CBC \
+        wolfAsync_GetThreshold(WC_ASYNC_THRESH_ID_AES_CBC)
+    #undef  WC_ASYNC_THRESH_AES_GCM
+    #define WC_ASYNC_THRESH_AES_GCM \
+        wolfAsync_GetThreshold(WC_ASYNC_THRESH_ID_AES_GCM)
+    #undef  WC_ASYNC_THRESH_DES3_CBC
+    #define WC_ASYNC_THRESH_DES3_CBC \
+        wolfAsync_GetThreshold(WC_ASYNC_THRESH_ID_DES3_CBC)
+    #undef  WC_ASYNC_THRESH_AES_CCM
+    #define WC_ASYNC_THRESH_AES_CCM \
+        wolfAsync_GetThreshold(WC_ASYNC_THRESH_ID_AES_CCM)
+    #undef  WC_ASYNC_THRESH_AES_XTS
+    #define WC_ASYNC_THRESH_AES_XTS \
+        wolfAsync_GetThreshold(WC_ASYNC_THRESH_ID_AES_XTS)
+    #undef  WC_ASYNC_THRESH_CHACHA_POLY
+    #define WC_ASYNC_THRESH_CHACHA_POLY \
+        wolfAsync_GetThreshold(WC_ASYNC_THRESH_ID_CHACHA_POLY)
+#else
+    #undef WC_ASYNC_THRESH_CALIBRATE
+#endif /* WC_ASYNC_THRESH_CALIBRATE */
+
 /* Overrides to allow disabling async support per algorithm */
 #ifndef WC_ASYNC_NO_CRYPT
     #ifndef WC_ASYNC_NO_ARC4
@@ -274,6 +472,9 @@ struct WC_ASYNC_DEV;
     #ifndef WC_ASYNC_NO_3DES
         #define WC_ASYNC_ENABLE_3DES
     #endif
+    #ifndef WC_ASYNC_NO_CHACHA_POLY
+        #define WC_ASYNC_ENABLE_CHACHA_POLY
+    #endif
 #endif /* WC_ASYNC_NO_CRYPT */
 #ifndef WC_ASYNC_NO_PKI
     #ifndef WC_ASYNC_NO_RSA_KEYGEN
@@ -337,6 +538,7 @@ struct WC_ASYNC_DEV;
 #define WOLFSSL_ASYNC_MARKER_MD5    0xBEEF000D
 #define WOLFSSL_ASYNC_MARKER_DH     0xBEEF000E
 #define WOLFSSL_ASYNC_MARKER_SHA3   0xBEEF000F
+#define WOLFSSL_ASYNC_MARKER_CHACHA_POLY 0xBEEF0010
 
 
 /* event flags (bit mask) */
@@ -354,6 +556,11 @@ typedef struct WC_ASYNC_DEV {
 
     /* event */
     WOLF_EVENT          event;
+#ifdef WC_ASYNC_COMPLETION_RING
+    WC_ASYNC_RING*      ring;        /* ring to push event to when done */
+    WC_ASYNC_RING*      ringOwner;   /* ring returning event, queue locked */
+    WOLF_EVENT*         ringEvent;   /* queued event, pushed when done */
+#endif
 
     /* context for driver */
 #ifdef HAVE_CAVIUM
@@ -365,6 +572,19 @@ typedef struct WC_ASYNC_DEV {
 #endif
 } WC_ASYNC_DEV;
 
+#ifdef WC_ASYNC_BATCH_SUBMIT
+    #ifndef WC_ASYNC_BATCH_MAX
+        #define WC_ASYNC_BATCH_MAX 32 /* operations held per batch */
+    #endif
+
+/* async operations started on this thread between wolfAsync_BatchBegin and
+ * wolfAsync_BatchSubmit are held and submitted together */
+typedef struct WC_ASYNC_BATCH {
+    WC_ASYNC_DEV*       devs[WC_ASYNC_BATCH_MAX];
+    int                 count;
+} WC_ASYNC_BATCH;
+#endif
+
 
 /* Interfaces */
 WOLFSSL_API int wolfAsync_HardwareStart(void);
@@ -384,6 +604,30 @@ WOLFSSL_API int wolfAsync_EventQueuePush(WOLF_EVENT_QUEUE* queue, WOLF_EVENT* ev
 WOLFSSL_API int wolfAsync_EventQueuePoll(WOLF_EVENT_QUEUE* queue, void* context_filter,
     WOLF_EVENT** events, int maxEvents, WOLF_EVENT_FLAG event_flags, int* eventCount);
 
+#ifdef WC_ASYNC_COMPLETION_RING
+WOLFSSL_API int wolfAsync_EventQueueRingInit(WOLF_EVENT_QUEUE* queue,
+    word32 size, void* heap);
+WOLFSSL_API void wolfAsync_EventQueueRingFree(WOLF_EVENT_QUEUE* queue);
+WOLFSSL_LOCAL void wolfAsync_EventComplete(WC_ASYNC_DEV* asyncDev);
+#endif
+
+#ifdef WC_ASYNC_BATCH_SUBMIT
+WOLFSSL_API int wolfAsync_BatchBegin(WC_ASYNC_BATCH* batch);
+WOLFSSL_API int wolfAsync_BatchSubmit(WC_ASYNC_BATCH* batch);
+WOLFSSL_LOCAL int wolfAsync_BatchAdd(WC_ASYNC_DEV* asyncDev);
+#endif
+
+#ifdef WC_ASYNC_EVENTFD
+WOLFSSL_API int wolfAsync_DevGetEventFd(int devId, int* fd);
+WOLFSSL_API int wolfAsync_DevAckEventFd(int devId);
+#endif
+
+#ifdef WC_ASYNC_THRESH_CALIBRATE
+WOLFSSL_API word32 wolfAsync_GetThreshold(int id);
+WOLFSSL_API int wolfAsync_SetThreshold(int id, word32 sz);
+WOLFSSL_API int wolfAsync_Calibrate(int devId);
+#endif
+
 WOLFSSL_API int wc_AsyncHandle(WC_ASYNC_DEV* asyncDev,
     WOLF_EVENT_QUEUE* queue, word32 flags);
 WOLFSSL_API int wc_AsyncWait(int ret, WC_ASYNC_DEV* asyncDev,
@@ -394,6 +638,10 @@ WOLFSSL_API int wc_AsyncSleep(word32 ms);
 #ifdef WOLFSSL_ASYNC_CRYPT_SW
     WOLFSSL_API int wc_AsyncSwInit(WC_ASYNC_DEV* dev, int type);
 #endif
+#ifdef WC_ASYNC_SW_POLL_BUDGET
+    WOLFSSL_API word32 wolfAsync_GetPollBudget(void);
+    WOLFSSL_API int wolfAsync_SetPollBudget(word32 usec);
+#endif
 
 /* Pthread Helpers */
 #ifndef WC_NO_ASYNC_THREADING
@@ -42,13 +42,17 @@
 #include <string.h>
 #include <errno.h>
 
-#if 0
-    /* Optional feature for partial QAT hashing support */
-    /* This will process updates through hardware instead of caching them */
-    #define QAT_HASH_ENABLE_PARTIAL
-#endif
+/* Optional feature for partial QAT hashing support (QAT_HASH_ENABLE_PARTIAL) */
+/* This will stream updates through hardware instead of caching them */
 #ifdef QAT_HASH_ENABLE_PARTIAL
-    #define MAX_QAT_HASH_BUFFERS 2
+    /* size of each partial sent to hardware (rounded down to block size) */
+    #ifndef QAT_HASH_STREAM_CHUNK
+        #define QAT_HASH_STREAM_CHUNK (64 * 1024)
+    #endif
+    /* number of chunks per hash, which bounds partials in flight */
+    #ifndef QAT_HASH_STREAM_DEPTH
+        #define QAT_HASH_STREAM_DEPTH 4
+    #endif
 #endif
 
 /* Detect QAT driver version */
@@ -103,20 +107,52 @@
 #ifndef QAT_POLL_RESP_QUOTA
     #define QAT_POLL_RESP_QUOTA (0) /* all pending */
 #endif
-
-/* TODO: Tune this value to get best performance */
-#ifndef WC_ASYNC_THRESH_AES_CBC
-    #define WC_ASYNC_THRESH_AES_CBC     128
+#ifdef QAT_USE_POLLING_THREAD
+    /* one polling thread per instance, backoff when no responses */
+    #ifndef QAT_POLL_SPIN_COUNT
+        #define QAT_POLL_SPIN_COUNT     (100)  /* empty polls before yield */
+    #endif
+    #ifndef QAT_POLL_YIELD_COUNT
+        #define QAT_POLL_YIELD_COUNT    (100)  /* yields before sleep */
+    #endif
+    #ifndef QAT_POLL_SLEEP_MAX_US
+        #define QAT_POLL_SLEEP_MAX_US   (1000) /* max sleep with ops in flight */
+    #endif
+    #ifndef QAT_POLL_IDLE_WAIT_MS
+        #define QAT_POLL_IDLE_WAIT_MS   (100)  /* max wait with none in flight */
+    #endif
+#endif
+#ifdef QAT_SW_FALLBACK
+    /* run RSA public key operations on CPU when instance is saturated,
+     * private key operations keep retrying on hardware */
+    #ifndef QAT_SW_RETRY_LIMIT
+        #define QAT_SW_RETRY_LIMIT    (10) /* ring full retries */
+    #endif
+    #ifndef QAT_SW_INFLIGHT_MAX
+        #define QAT_SW_INFLIGHT_MAX   (1024) /* requests in flight per instance */
+    #endif
+#endif
+#ifdef QAT_SCHED_LOAD
+    /* in flight difference needed to move a PKE operation to another instance */
+    #ifndef QAT_SCHED_MIN_DIFF
+        #define QAT_SCHED_MIN_DIFF    (2)
+    #endif
+    #ifndef QAT_SCHED_REMOTE_DIFF
+        #define QAT_SCHED_REMOTE_DIFF (8)  /* instance on another NUMA node */
+    #endif
 #endif
-#ifndef WC_ASYNC_THRESH_AES_GCM
-    #define WC_ASYNC_THRESH_AES_GCM     128
+#ifndef QAT_NUMA_MAX_USERS
+    /* threads per instance before a remote node instance is preferred */
+    #define QAT_NUMA_MAX_USERS (4)
 #endif
-#ifndef WC_ASYNC_THRESH_DES3_CBC
-    #define WC_ASYNC_THRESH_DES3_CBC    128
+#ifndef QAT_POLL_MAX_INSTANCES
+    /* instances tracked for single poll per queue sweep */
+    #define QAT_POLL_MAX_INSTANCES (256)
 #endif
 
 /* Macros */
 #define INVALID_STATUS -256
+#define QAT_STATUS_SW_DONE -257 /* operation completed on CPU */
 
 
 #if !defined(NO_SHA256) || defined(WOLFSSL_SHA512) || defined(WOLFSSL_SHA384) ||\
@@ -140,22 +176,89 @@ struct WC_ASYNC_DEV;
 struct WC_BIGINT;
 struct IntelQaDev;
 struct WC_RNG;
+struct IntelQaHashChunk;
+#ifdef QAT_HASH_ENABLE_PARTIAL
+struct IntelQaHashStream;
+#endif
+
+/* one fragment of a scatter-gather buffer */
+typedef struct IntelQaSgBuf {
+    byte*  data;
+    word32 len;
+} IntelQaSgBuf;
+
+#if defined(HAVE_AESGCM) && defined(WC_ASYNC_BATCH_SUBMIT)
+/* one independent record of an AES-GCM burst */
+typedef struct IntelQaGcmReq {
+    struct WC_ASYNC_DEV* dev; /* per record, not in use by another operation */
+    byte*       out;
+    const byte* in;
+    word32      sz;
+    const byte* key;
+    word32      keySz;
+    const byte* iv;
+    word32      ivSz;
+    byte*       authTag; /* written on encrypt, checked on decrypt */
+    word32      authTagSz;
+    const byte* authIn;
+    word32      authInSz;
+    int         ret;     /* result of this record */
+} IntelQaGcmReq;
+#endif
+
+#ifndef QAT_SG_MAX_BUFFERS
+    #define QAT_SG_MAX_BUFFERS 32 /* fragments per operation */
+#endif
 
 #if defined(QAT_ENABLE_HASH) || defined(QAT_ENABLE_CRYPTO)
+#ifndef QAT_SYM_LIST_BUFFERS
+    /* buffers in the list allocated at open, grown for larger operations */
+    #define QAT_SYM_LIST_BUFFERS 8
+#endif
+#ifndef QAT_NO_SYM_SESSION_CACHE
+    #ifndef QAT_SYM_SESSION_KEY_MAX
+        /* max cipher + auth key bytes cached, larger keys are not reused */
+        #define QAT_SYM_SESSION_KEY_MAX 128
+    #endif
+
+/* parameters the open symmetric session was initialized with */
+typedef struct IntelQaSymSession {
+    CpaCySymOp symOperation;
+    CpaBoolean partialsNotRequired; /* one-shot or streamed */
+    CpaCySymCipherAlgorithm cipherAlgorithm;
+    CpaCySymCipherDirection cipherDirection;
+    CpaCySymHashAlgorithm hashAlgorithm;
+    CpaCySymHashMode hashMode;
+    word32 digestSz;
+    word32 aadSz;
+    word32 cipherKeySz;
+    word32 authKeySz;
+    byte key[QAT_SYM_SESSION_KEY_MAX]; /* cipher key then auth key */
+} IntelQaSymSession;
+#endif
+
 /* symmetric context */
 typedef struct IntelQaSymCtx {
     CpaCySymOpData opData;
     CpaCySymSessionCtx symCtxSrc;
     CpaCySymSessionCtx symCtx;
     word32 symCtxSize;
+#ifndef QAT_NO_SYM_SESSION_CACHE
+    IntelQaSymSession session;
+#endif
 
     /* flags */
     word32 isOpen:1;
     word32 isCopy:1;
+    word32 isCached:1; /* session matches "session" and can be reused */
 } IntelQaSymCtx;
 #endif
 
 typedef void (*IntelQaFreeFunc)(struct WC_ASYNC_DEV*);
+#ifdef WC_ASYNC_BATCH_SUBMIT
+/* issues the prepared operation to the instance */
+typedef CpaStatus (*IntelQaSubmitFunc)(struct WC_ASYNC_DEV*);
+#endif
 
 #if defined(QAT_ENABLE_PKI) && !defined(NO_RSA) && defined (WOLFSSL_KEY_GEN)
     #ifndef QAT_PRIME_GEN_TRIES
@@ -206,6 +309,16 @@ typedef struct IntelQaDev {
 
     /* operations */
     IntelQaFreeFunc freeFunc;
+#ifdef WC_ASYNC_BATCH_SUBMIT
+    IntelQaSubmitFunc submitFunc; /* set while held in a batch */
+#endif
+#ifdef QAT_SW_FALLBACK
+    byte swFallback; /* ring full, run public key op on CPU at next submit */
+#endif
+#if defined(QAT_ENABLE_CRYPTO) || defined(QAT_ENABLE_HASH)
+    CpaBufferList* symList; /* buffer list and driver metadata, reused */
+    word32 symListMax;      /* flat buffers symList has room for */
+#endif
     union {
     #if defined(QAT_ENABLE_PKI) && !defined(NO_RSA)
         #ifdef WOLFSSL_KEY_GEN
@@ -246,6 +359,11 @@ typedef struct IntelQaDev {
             word32 authTagSz;
             byte* iv;
             word32 ivSz;
+            word32 sgCount; /* scatter-gather fragments, 0 for in/out */
+            word32 hdrSz;   /* chained cipher HMAC: MAC header before record */
+            word32 padSz;
+            byte verify;
+            int verifyErr;  /* returned when appended tag does not verify */
         } cipher;
     #endif
     #if defined(QAT_ENABLE_PKI) && defined(HAVE_ECC)
@@ -291,14 +409,14 @@ typedef struct IntelQaDev {
         struct {
             IntelQaSymCtx ctx;
             CpaBufferList* srcList;
-            byte* tmpIn; /* tmp buffer to hold anything pending less than block size */
-            word32 tmpInSz;
-            word32 tmpInBufSz;
+            /* cached input in fixed size chunks, shared by copies */
+            struct IntelQaHashChunk** chunks;
+            word32 chunkCnt;
+            word32 chunkMax;
+            word32 inSz;
 
         #ifdef QAT_HASH_ENABLE_PARTIAL
-            int bufferCount;
-            byte* buffers[MAX_QAT_HASH_BUFFERS];
-            word32 buffersSz[MAX_QAT_HASH_BUFFERS];
+            struct IntelQaHashStream* stream; /* partials sent to hardware */
         #endif
         } hash;
     #endif
@@ -320,11 +438,6 @@ typedef struct IntelQaDev {
         } drbg;
     #endif
     } op;
-
-#ifdef QAT_USE_POLLING_THREAD
-    pthread_t pollingThread;
-    byte pollingCy;
-#endif
 } IntelQaDev;
 
 
@@ -342,9 +455,19 @@ WOLFSSL_LOCAL void IntelQaClose(struct WC_ASYNC_DEV* dev);
 
 WOLFSSL_LOCAL int IntelQaDevCopy(struct WC_ASYNC_DEV* src, struct WC_ASYNC_DEV* dst);
 
+WOLFSSL_LOCAL int IntelQaPollInstance(int devId);
+WOLFSSL_LOCAL int IntelQaPollDev(struct WC_ASYNC_DEV* dev);
 WOLFSSL_LOCAL int IntelQaPoll(struct WC_ASYNC_DEV* dev);
+WOLFSSL_LOCAL void IntelQaOpFinish(struct WC_ASYNC_DEV* dev);
 
 WOLFSSL_LOCAL int IntelQaGetCyInstanceCount(void);
+#ifdef WC_ASYNC_BATCH_SUBMIT
+WOLFSSL_LOCAL int IntelQaBatchSubmit(struct WC_ASYNC_DEV** devs, int count);
+#endif
+#ifdef WC_ASYNC_EVENTFD
+WOLFSSL_LOCAL int IntelQaGetEventFd(int devId, int* fd);
+WOLFSSL_LOCAL int IntelQaAckEventFd(int devId);
+#endif
 
 #ifndef NO_RSA
     #ifdef WOLFSSL_KEY_GEN
@@ -386,6 +509,34 @@ WOLFSSL_LOCAL int IntelQaGetCyInstanceCount(void);
             const byte* key, word32 keySz,
             byte* iv, word32 ivSz);
     #endif /* HAVE_AES_DECRYPT */
+
+        /* scatter-gather versions process fragments in place */
+        WOLFSSL_API int IntelQaSymAesCbcEncryptSg(struct WC_ASYNC_DEV* dev,
+            const IntelQaSgBuf* sg, word32 sgCnt,
+            const byte* key, word32 keySz,
+            byte* iv, word32 ivSz);
+    #ifdef HAVE_AES_DECRYPT
+        WOLFSSL_API int IntelQaSymAesCbcDecryptSg(struct WC_ASYNC_DEV* dev,
+            const IntelQaSgBuf* sg, word32 sgCnt,
+            const byte* key, word32 keySz,
+            byte* iv, word32 ivSz);
+    #endif /* HAVE_AES_DECRYPT */
+
+    #ifndef NO_HMAC
+        /* TLS MAC-then-encrypt of a record as one chained operation */
+        WOLFSSL_API int IntelQaSymAesCbcHmacEncrypt(struct WC_ASYNC_DEV* dev,
+            byte* out, word32* outSz, const byte* in, word32 sz,
+            const byte* key, word32 keySz, byte* iv, word32 ivSz,
+            int macType, const byte* macKey, word32 macKeySz,
+            const byte* macHdr, word32 macHdrSz);
+    #ifdef HAVE_AES_DECRYPT
+        WOLFSSL_API int IntelQaSymAesCbcHmacDecrypt(struct WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz, word32 dataSz,
+            const byte* key, word32 keySz, byte* iv, word32 ivSz,
+            int macType, const byte* macKey, word32 macKeySz,
+            const byte* macHdr, word32 macHdrSz);
+    #endif /* HAVE_AES_DECRYPT */
+    #endif /* !NO_HMAC */
     #endif /* HAVE_AES_CBC */
 
     #ifdef HAVE_AESGCM
@@ -403,9 +554,82 @@ WOLFSSL_LOCAL int IntelQaGetCyInstanceCount(void);
             const byte* authTag, word32 authTagSz,
             const byte* authIn, word32 authInSz);
     #endif /* HAVE_AES_DECRYPT */
+
+        WOLFSSL_API int IntelQaSymAesGcmEncryptSg(struct WC_ASYNC_DEV* dev,
+            const IntelQaSgBuf* sg, word32 sgCnt,
+            const byte* key, word32 keySz,
+            const byte* iv, word32 ivSz,
+            byte* authTag, word32 authTagSz,
+            const byte* authIn, word32 authInSz);
+    #ifdef HAVE_AES_DECRYPT
+        WOLFSSL_API int IntelQaSymAesGcmDecryptSg(struct WC_ASYNC_DEV* dev,
+            const IntelQaSgBuf* sg, word32 sgCnt,
+            const byte* key, word32 keySz,
+            const byte* iv, word32 ivSz,
+            const byte* authTag, word32 authTagSz,
+            const byte* authIn, word32 authInSz);
+    #endif /* HAVE_AES_DECRYPT */
+
+    #ifdef WC_ASYNC_BATCH_SUBMIT
+        /* submit many records as one burst and wait for all of them */
+        WOLFSSL_API int IntelQaSymAesGcmEncryptBurst(IntelQaGcmReq* reqs,
+            word32 count);
+    #ifdef HAVE_AES_DECRYPT
+        WOLFSSL_API int IntelQaSymAesGcmDecryptBurst(IntelQaGcmReq* reqs,
+            word32 count);
+    #endif /* HAVE_AES_DECRYPT */
+    #endif /* WC_ASYNC_BATCH_SUBMIT */
     #endif /* HAVE_AESGCM */
+
+    #ifdef HAVE_AESCCM
+        WOLFSSL_LOCAL int IntelQaSymAesCcmEncrypt(struct WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz,
+            const byte* key, word32 keySz,
+            const byte* nonce, word32 nonceSz,
+            byte* authTag, word32 authTagSz,
+            const byte* authIn, word32 authInSz);
+    #ifdef HAVE_AES_DECRYPT
+        WOLFSSL_LOCAL int IntelQaSymAesCcmDecrypt(struct WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz,
+            const byte* key, word32 keySz,
+            const byte* nonce, word32 nonceSz,
+            const byte* authTag, word32 authTagSz,
+            const byte* authIn, word32 authInSz);
+    #endif /* HAVE_AES_DECRYPT */
+    #endif /* HAVE_AESCCM */
+
+    #ifdef WOLFSSL_AES_XTS
+        /* key is both XTS keys, iv is the tweak */
+        WOLFSSL_LOCAL int IntelQaSymAesXtsEncrypt(struct WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz,
+            const byte* key, word32 keySz,
+            const byte* iv, word32 ivSz);
+    #ifdef HAVE_AES_DECRYPT
+        WOLFSSL_LOCAL int IntelQaSymAesXtsDecrypt(struct WC_ASYNC_DEV* dev,
+            byte* out, const byte* in, word32 sz,
+            const byte* key, word32 keySz,
+            const byte* iv, word32 ivSz);
+    #endif /* HAVE_AES_DECRYPT */
+    #endif /* WOLFSSL_AES_XTS */
 #endif /* !NO_AES */
 
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305) && defined(QAT_V2_4_PLUS)
+    WOLFSSL_LOCAL int IntelQaSymChaCha20Poly1305Encrypt(
+                struct WC_ASYNC_DEV* dev,
+                byte* out, const byte* in, word32 sz,
+                const byte* key, word32 keySz,
+                const byte* iv, word32 ivSz,
+                byte* authTag, word32 authTagSz,
+                const byte* authIn, word32 authInSz);
+    WOLFSSL_LOCAL int IntelQaSymChaCha20Poly1305Decrypt(
+                struct WC_ASYNC_DEV* dev,
+                byte* out, const byte* in, word32 sz,
+                const byte* key, word32 keySz,
+                const byte* iv, word32 ivSz,
+                const byte* authTag, word32 authTagSz,
+                const byte* authIn, word32 authInSz);
+#endif /* HAVE_CHACHA && HAVE_POLY1305 && QAT_V2_4_PLUS */
+
 #ifndef NO_DES3
     WOLFSSL_LOCAL int IntelQaSymDes3CbcEncrypt(struct WC_ASYNC_DEV* dev,
                 byte* out, const byte* in, word32 sz,
@@ -451,6 +675,12 @@ WOLFSSL_LOCAL int IntelQaGetCyInstanceCount(void);
         const byte* in, word32 sz);
 #endif
 
+#ifdef QAT_ENABLE_HASH
+    WOLFSSL_API int IntelQaSymHashSg(struct WC_ASYNC_DEV* dev, byte* out,
+        const IntelQaSgBuf* sg, word32 sgCnt,
+        CpaCySymHashAlgorithm hashAlgorithm);
+#endif
+
 #ifdef HAVE_ECC
     #ifdef HAVE_ECC_DHE
         WOLFSSL_LOCAL int IntelQaEccPointMul(struct WC_ASYNC_DEV* dev,
@@ -35,6 +35,12 @@ void qaeMemDestroy(void);
 #endif
 
 
+WOLFSSL_LOCAL void IntelQaMemSetNode(int node);
+
+#ifdef USE_QAE_SLAB
+    WOLFSSL_LOCAL void IntelQaMemSlabFree(void);
+#endif
+
 #ifdef WOLFSSL_TRACK_MEMORY
     WOLFSSL_API int InitMemoryTracker(void);
     WOLFSSL_API void ShowMemoryTracker(void);
@@ -59,6 +65,15 @@ WOLFSSL_API void* IntelQaRealloc(void *ptr, size_t size, void* heap, int type
 #endif
 );
 
+#ifndef QAT_MEM_POOL_MAX
+    #define QAT_MEM_POOL_MAX 16 /* max registered DMA buffer pools */
+#endif
+
+/* register application owned DMA-able memory, buffers inside it are passed to
+ * hardware as-is instead of being copied into NUMA memory */
+WOLFSSL_API int IntelQaMemRegisterPool(void* base, size_t size);
+WOLFSSL_API int IntelQaMemUnregisterPool(void* base);
+
 #endif /* HAVE_INTEL_QA */
 
 #endif /* _QUICKASSIST_MEM_H_ */